@@ -80,4 +80,88 @@ void free_bmp(BMPImage* image) {
         free(image->data);
         free(image);
     }
+}
+
+BMPStream* bmp_open_read(const char* filename) {
+    FILE* f = fopen(filename, "rb");
+    if (!f) {
+        perror("Failed to open input file");
+        return NULL;
+    }
+
+    BMPStream* stream = (BMPStream*)malloc(sizeof(BMPStream));
+    if (!stream) {
+        fclose(f);
+        return NULL;
+    }
+    stream->file = f;
+
+    if (fread(&stream->header, sizeof(BMPHeader), 1, f) != 1 ||
+        fread(&stream->info_header, sizeof(BMPInfoHeader), 1, f) != 1 ||
+        stream->header.type != 0x4D42) { // 'BM'
+        fprintf(stderr, "Error: Not a BMP file.\n");
+        fclose(f);
+        free(stream);
+        return NULL;
+    }
+
+    if (stream->info_header.bit_count != 24) {
+        fprintf(stderr, "Error: Only 24-bit BMP files are supported.\n");
+        fclose(f);
+        free(stream);
+        return NULL;
+    }
+
+    stream->padding = (4 - (stream->info_header.width * sizeof(Pixel)) % 4) % 4;
+    fseek(f, stream->header.offset, SEEK_SET);
+    return stream;
+}
+
+BMPStream* bmp_open_write(const char* filename, const BMPHeader* header, const BMPInfoHeader* info_header) {
+    FILE* f = fopen(filename, "wb");
+    if (!f) {
+        perror("Failed to open output file");
+        return NULL;
+    }
+
+    BMPStream* stream = (BMPStream*)malloc(sizeof(BMPStream));
+    if (!stream) {
+        fclose(f);
+        return NULL;
+    }
+    stream->file = f;
+    stream->header = *header;
+    stream->info_header = *info_header;
+    stream->padding = (4 - (info_header->width * sizeof(Pixel)) % 4) % 4;
+
+    fwrite(&stream->header, sizeof(BMPHeader), 1, f);
+    fwrite(&stream->info_header, sizeof(BMPInfoHeader), 1, f);
+    return stream;
+}
+
+int bmp_read_row(BMPStream* stream, Pixel* row) {
+    int width = stream->info_header.width;
+    if (fread(row, sizeof(Pixel), width, stream->file) != (size_t)width) {
+        return 0;
+    }
+    fseek(stream->file, stream->padding, SEEK_CUR);
+    return 1;
+}
+
+int bmp_write_row(BMPStream* stream, const Pixel* row) {
+    int width = stream->info_header.width;
+    char pad_bytes[3] = {0,0,0};
+    if (fwrite(row, sizeof(Pixel), width, stream->file) != (size_t)width) {
+        return 0;
+    }
+    return fwrite(pad_bytes, 1, stream->padding, stream->file) == (size_t)stream->padding;
+}
+
+int bmp_close(BMPStream* stream) {
+    int ok = 1;
+    if (stream) {
+        ok = fclose(stream->file) == 0;
+        free(stream);
+    }
+    return ok;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define BMP_HANDLER_H
 
 #include <stdint.h>
+#include <stdio.h>
 
 // Структура для хранения пикселя (24-бит)
 #pragma pack(push, 1)
@@ -44,4 +45,20 @@ BMPImage* read_bmp(const char* filename);
 int write_bmp(const char* filename, BMPImage* image);
 void free_bmp(BMPImage* image);
 
+// Построчное чтение и запись без загрузки всего изображения в память.
+// Строки идут в порядке хранения в файле (снизу вверх), как и в BMPImage::data.
+typedef struct {
+    FILE* file;
+    BMPHeader header;
+    BMPInfoHeader info_header;
+    int padding;
+} BMPStream;
+
+BMPStream* bmp_open_read(const char* filename);
+BMPStream* bmp_open_write(const char* filename, const BMPHeader* header, const BMPInfoHeader* info_header);
+int bmp_read_row(BMPStream* stream, Pixel* row);
+int bmp_write_row(BMPStream* stream, const Pixel* row);
+// Возвращает 0, если при закрытии файла произошла ошибка
+int bmp_close(BMPStream* stream);
+
 #endif // BMP_HANDLER_H
\ No newline at end of file
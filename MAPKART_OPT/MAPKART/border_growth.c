@@ -0,0 +1,90 @@
+#include "border_growth.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Пиксель границы index впервые достигнут (или достигнут снова на том же шаге)
+// из пикселя с номером label: при равенстве расстояний остаётся меньший номер
+static inline void reach_pixel(BorderGrowth* growth, int* queue, int* queue_end, int index, int label,
+                               uint16_t step) {
+    uint16_t* distance = growth->distance;
+    if (distance[index] == BORDER_UNREACHED) {
+        distance[index] = step;
+        growth->labels[index] = label;
+        queue[(*queue_end)++] = index;
+    } else if (distance[index] == step && label < growth->labels[index]) {
+        growth->labels[index] = label;
+    }
+}
+
+BorderGrowth* grow_regions_into_borders(const int* region_map, int width, int height, int max_distance) {
+    BorderGrowth* growth = (BorderGrowth*)malloc(sizeof(BorderGrowth));
+    if (!growth) {
+        fprintf(stderr, "Failed to allocate memory for border growth.\n");
+        return NULL;
+    }
+    size_t num_pixels = (size_t)width * height;
+    growth->width = width;
+    growth->height = height;
+    growth->max_distance = max_distance;
+    growth->labels = (int*)malloc(num_pixels * sizeof(int));
+    growth->distance = (uint16_t*)malloc(num_pixels * sizeof(uint16_t));
+    int* queue = (int*)malloc(num_pixels * sizeof(int));
+    if (!growth->labels || !growth->distance || !queue) {
+        fprintf(stderr, "Failed to allocate memory for border growth.\n");
+        free(queue);
+        free_border_growth(growth);
+        return NULL;
+    }
+    memcpy(growth->labels, region_map, num_pixels * sizeof(int));
+
+    // Шаг 0: источники - все пиксели регионов
+    int queue_end = 0;
+    for (size_t i = 0; i < num_pixels; i++) {
+        if (region_map[i] > 0) {
+            growth->distance[i] = 0;
+            queue[queue_end++] = (int)i;
+        } else {
+            growth->distance[i] = BORDER_UNREACHED;
+        }
+    }
+
+    // Поиск в ширину по слоям: слой step целиком обрабатывается раньше слоя step + 1,
+    // поэтому номера пикселей слоя окончательны, когда из них идёт следующий шаг
+    int queue_begin = 0;
+    for (uint16_t step = 1; step <= max_distance && queue_begin < queue_end; step++) {
+        int layer_end = queue_end;
+        for (; queue_begin < layer_end; queue_begin++) {
+            int index = queue[queue_begin];
+            int x = index % width;
+            int y = index / width;
+            int label = growth->labels[index];
+            // Крайние строки и столбцы не прорастают: цель должна быть внутри
+            // по обеим координатам (источник - пиксель региона - может лежать на краю)
+            int inner_column = x > 0 && x < width - 1;
+            int inner_row = y > 0 && y < height - 1;
+            if (inner_column && y > 1 && region_map[index - width] == 0) {
+                reach_pixel(growth, queue, &queue_end, index - width, label, step);
+            }
+            if (inner_column && y < height - 2 && region_map[index + width] == 0) {
+                reach_pixel(growth, queue, &queue_end, index + width, label, step);
+            }
+            if (inner_row && x > 1 && region_map[index - 1] == 0) {
+                reach_pixel(growth, queue, &queue_end, index - 1, label, step);
+            }
+            if (inner_row && x < width - 2 && region_map[index + 1] == 0) {
+                reach_pixel(growth, queue, &queue_end, index + 1, label, step);
+            }
+        }
+    }
+    free(queue);
+    return growth;
+}
+
+void free_border_growth(BorderGrowth* growth) {
+    if (growth) {
+        free(growth->labels);
+        free(growth->distance);
+        free(growth);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#ifndef BORDER_GROWTH_H
+#define BORDER_GROWTH_H
+
+#include <stdint.h>
+
+// Наибольшая поддерживаемая толщина границы (расстояния хранятся в uint16_t)
+#define BORDER_MAX_WIDTH 1024
+// Расстояние пикселя границы, до которого не дошёл ни один регион
+#define BORDER_UNREACHED UINT16_MAX
+
+// Регионы, «проросшие» в пиксели границы: каждый пиксель границы на расстоянии
+// не больше max_distance шагов (4-связно) от ближайшего региона получает номер
+// этого региона (при равенстве - меньший из номеров соседей предыдущего шага).
+// Получается разбиение, похожее на диаграмму Вороного, ограниченное толщиной границы.
+typedef struct {
+    int width;
+    int height;
+    int max_distance;
+    int* labels;        // Как region_map, но с проросшими номерами (0 - не достигнут)
+    uint16_t* distance; // 0 - пиксель региона, 1..max_distance - границы, BORDER_UNREACHED
+} BorderGrowth;
+
+// Многоисточниковый поиск в ширину от всех пикселей регионов, O(width * height).
+// Крайние строки и столбцы изображения не прорастают: как и в основном правиле
+// касаний через границу, регионы через них не соприкасаются.
+// Возвращает NULL при нехватке памяти.
+BorderGrowth* grow_regions_into_borders(const int* region_map, int width, int height, int max_distance);
+void free_border_growth(BorderGrowth* growth);
+
+#endif // BORDER_GROWTH_H
\ No newline at end of file
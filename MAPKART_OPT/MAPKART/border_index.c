@@ -0,0 +1,138 @@
+#include "border_index.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Слово w кандидатов строки y (1 <= y < height - 1): нулевой бит маски,
+// у которого установлены хотя бы два из четырёх соседних битов
+static inline uint64_t candidate_word(const ForegroundMask* mask, const uint64_t* up, const uint64_t* cur,
+                                      const uint64_t* down, int w) {
+    const int last_word = mask->words_per_row - 1;
+    uint64_t left = cur[w] << 1 | (w > 0 ? cur[w - 1] >> 63 : 0);
+    uint64_t right = cur[w] >> 1 | (w < last_word ? cur[w + 1] << 63 : 0);
+    // Не меньше двух из четырёх: пара внутри одной половины или по одному в каждой
+    uint64_t at_least_two = (up[w] & down[w]) | (left & right) | ((up[w] | down[w]) & (left | right));
+    uint64_t word = ~cur[w] & at_least_two & row_valid_bits(mask->width, w);
+    if (w == 0) word &= ~(uint64_t)1;
+    if (w == last_word) word &= ~((uint64_t)1 << ((mask->width - 1) & 63));
+    return word;
+}
+
+// Отрезки кандидатов строки y. runs должен вмещать width / 2 + 1 отрезков.
+static int border_runs_of_row(const ForegroundMask* mask, int y, BorderRun* runs) {
+    if (y <= 0 || y >= mask->height - 1) return 0;
+    const uint64_t* up = mask_row(mask, y - 1);
+    const uint64_t* cur = mask_row(mask, y);
+    const uint64_t* down = mask_row(mask, y + 1);
+    int count = 0;
+    int run_start = -1;
+    uint64_t previous = 0;
+    for (int w = 0; w < mask->words_per_row; w++) {
+        uint64_t word = candidate_word(mask, up, cur, down, w);
+        // Установленные биты changes - начала и концы отрезков по порядку
+        uint64_t changes = word ^ (word << 1 | previous >> 63);
+        previous = word;
+        while (changes) {
+            int x = (w << 6) + lowest_bit_index(changes);
+            changes &= changes - 1;
+            if (run_start < 0) {
+                run_start = x;
+            } else {
+                runs[count].start = run_start;
+                runs[count].length = x - run_start;
+                count++;
+                run_start = -1;
+            }
+        }
+    }
+    // Крайний столбец в кандидаты не входит, поэтому отрезок всегда закрыт внутри строки
+    return count;
+}
+
+BorderIndex* create_border_index(int width, int height) {
+    BorderIndex* index = (BorderIndex*)malloc(sizeof(BorderIndex));
+    if (!index) {
+        fprintf(stderr, "Failed to allocate memory for border index.\n");
+        return NULL;
+    }
+    index->width = width;
+    index->height = height;
+    index->row_start = (int*)calloc(height + 1, sizeof(int));
+    index->runs = NULL;
+    index->num_runs = 0;
+    index->num_pixels = 0;
+    if (!index->row_start) {
+        fprintf(stderr, "Failed to allocate memory for border index.\n");
+        free(index);
+        return NULL;
+    }
+    return index;
+}
+
+int collect_border_runs(BorderIndex* index, const ForegroundMask* mask, int y, BorderRunList* list) {
+    int max_row_runs = mask->width / 2 + 1;
+    if (list->count + max_row_runs > list->capacity) {
+        int new_capacity = list->capacity ? list->capacity * 2 : 1024;
+        while (new_capacity < list->count + max_row_runs) new_capacity *= 2;
+        BorderRun* runs = (BorderRun*)realloc(list->runs, (size_t)new_capacity * sizeof(BorderRun));
+        if (!runs) return 0;
+        list->runs = runs;
+        list->capacity = new_capacity;
+    }
+    int count = border_runs_of_row(mask, y, list->runs + list->count);
+    list->count += count;
+    index->row_start[y + 1] = count; // Префиксные суммы - в finish_border_index()
+    return 1;
+}
+
+int finish_border_index(BorderIndex* index, BorderRunList* lists, int num_lists) {
+    for (int y = 0; y < index->height; y++) {
+        index->row_start[y + 1] += index->row_start[y];
+    }
+    index->num_runs = index->row_start[index->height];
+
+    int ok = 1;
+    if (num_lists == 1) {
+        // Единственный список уже лежит в порядке строк
+        index->runs = lists[0].runs;
+        lists[0].runs = NULL;
+    } else {
+        index->runs = (BorderRun*)malloc(((size_t)index->num_runs + 1) * sizeof(BorderRun));
+        if (index->runs) {
+            int offset = 0;
+            for (int i = 0; i < num_lists; i++) {
+                if (lists[i].count) {
+                    memcpy(index->runs + offset, lists[i].runs, (size_t)lists[i].count * sizeof(BorderRun));
+                }
+                offset += lists[i].count;
+            }
+        } else {
+            fprintf(stderr, "Failed to allocate memory for border index.\n");
+            ok = 0;
+        }
+    }
+    for (int i = 0; i < num_lists; i++) {
+        free_border_run_list(&lists[i]);
+    }
+    if (ok) {
+        for (int i = 0; i < index->num_runs; i++) {
+            index->num_pixels += index->runs[i].length;
+        }
+    }
+    return ok;
+}
+
+void free_border_run_list(BorderRunList* list) {
+    free(list->runs);
+    list->runs = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+void free_border_index(BorderIndex* index) {
+    if (index) {
+        free(index->row_start);
+        free(index->runs);
+        free(index);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#ifndef BORDER_INDEX_H
+#define BORDER_INDEX_H
+
+#include "foreground_mask.h"
+
+// Отрезок строки из пикселей границы: [start, start + length)
+typedef struct {
+    int start;
+    int length;
+} BorderRun;
+
+// Индекс пикселей границы, через которые могут касаться регионы: пиксели
+// границы внутри изображения (не в крайних строках и столбцах), у которых
+// не меньше двух белых соседей из четырёх. Остальные пиксели границы не
+// разделяют два региона и построителю графа не нужны.
+// Отрезки строки y занимают runs[row_start[y]] .. runs[row_start[y + 1] - 1].
+typedef struct {
+    int width;
+    int height;
+    int* row_start; // height + 1 элементов
+    BorderRun* runs;
+    int num_runs;
+    long num_pixels;
+} BorderIndex;
+
+// Отрезки границы полосы строк, собранные во время разметки
+typedef struct {
+    BorderRun* runs;
+    int count;
+    int capacity;
+} BorderRunList;
+
+// Пустой индекс: строки заполняет разметка через collect_border_runs(),
+// после неё finish_border_index() собирает отрезки в общий массив.
+// Возвращает NULL при нехватке памяти.
+BorderIndex* create_border_index(int width, int height);
+
+// Дописывает в list отрезки кандидатов строки y маски и запоминает их число
+// в индексе. Полосы с разными строками можно собирать параллельно, каждую в
+// свой список. Возвращает 0 при нехватке памяти.
+int collect_border_runs(BorderIndex* index, const ForegroundMask* mask, int y, BorderRunList* list);
+
+// Склеивает списки полос (по возрастанию строк) в индекс и освобождает их.
+// Возвращает 0 при нехватке памяти.
+int finish_border_index(BorderIndex* index, BorderRunList* lists, int num_lists);
+
+void free_border_run_list(BorderRunList* list);
+void free_border_index(BorderIndex* index);
+
+static inline const BorderRun* border_row_runs(const BorderIndex* index, int y, int* count) {
+    *count = index->row_start[y + 1] - index->row_start[y];
+    return index->runs + index->row_start[y];
+}
+
+#endif // BORDER_INDEX_H
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "coloring_order.h"
+#include <stdlib.h>
+
+static inline int csr_degree(const Graph* csr, int v) {
+    return csr->offsets[v + 1] - csr->offsets[v];
+}
+
+int largest_first_order(const Graph* csr, int* order) {
+    int n = csr->num_vertices;
+    int max_degree = 0;
+    for (int v = 1; v < n; v++) {
+        if (csr_degree(csr, v) > max_degree) max_degree = csr_degree(csr, v);
+    }
+    int* bin = (int*)calloc(max_degree + 2, sizeof(int));
+    if (!bin) return 0;
+    // Корзина степени d начинается после всех вершин большей степени
+    for (int v = 1; v < n; v++) {
+        bin[max_degree - csr_degree(csr, v) + 1]++;
+    }
+    for (int d = 0; d <= max_degree; d++) {
+        bin[d + 1] += bin[d];
+    }
+    for (int v = 1; v < n; v++) {
+        order[bin[max_degree - csr_degree(csr, v)]++] = v;
+    }
+    free(bin);
+    return 1;
+}
+
+int smallest_last_order(const Graph* csr, int* order, int* degeneracy) {
+    int n = csr->num_vertices;
+    int max_degree = 0;
+    for (int v = 1; v < n; v++) {
+        if (csr_degree(csr, v) > max_degree) max_degree = csr_degree(csr, v);
+    }
+    // Корзины Batagelj-Zaversnik: vert - вершины по возрастанию текущей степени,
+    // pos - место вершины в vert, bin[d] - начало корзины степени d
+    int* degree = (int*)malloc(n * sizeof(int));
+    int* vert = (int*)malloc(n * sizeof(int));
+    int* pos = (int*)malloc(n * sizeof(int));
+    int* bin = (int*)calloc(max_degree + 2, sizeof(int));
+    if (!degree || !vert || !pos || !bin) {
+        free(degree);
+        free(vert);
+        free(pos);
+        free(bin);
+        return 0;
+    }
+    for (int v = 1; v < n; v++) {
+        degree[v] = csr_degree(csr, v);
+        bin[degree[v] + 1]++;
+    }
+    for (int d = 0; d <= max_degree; d++) {
+        bin[d + 1] += bin[d];
+    }
+    for (int v = 1; v < n; v++) {
+        pos[v] = bin[degree[v]]++;
+        vert[pos[v]] = v;
+    }
+    for (int d = max_degree; d > 0; d--) {
+        bin[d] = bin[d - 1];
+    }
+    bin[0] = 0;
+
+    // Удаление по одной вершине наименьшей степени: сосед большей степени
+    // переносится в начало своей корзины, и граница корзины сдвигается на 1
+    int k = 0;
+    for (int i = 0; i < n - 1; i++) {
+        int v = vert[i];
+        if (degree[v] > k) k = degree[v];
+        order[n - 2 - i] = v;
+        for (int e = csr->offsets[v]; e < csr->offsets[v + 1]; e++) {
+            int u = csr->neighbors[e];
+            if (degree[u] <= degree[v]) continue;
+            int du = degree[u];
+            int pu = pos[u];
+            int pw = bin[du];
+            int w = vert[pw];
+            if (u != w) {
+                pos[u] = pw;
+                vert[pu] = w;
+                pos[w] = pu;
+                vert[pw] = u;
+            }
+            bin[du]++;
+            degree[u]--;
+        }
+    }
+    *degeneracy = k;
+    free(degree);
+    free(vert);
+    free(pos);
+    free(bin);
+    return 1;
+}
\ No newline at end of file
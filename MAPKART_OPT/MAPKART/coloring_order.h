@@ -0,0 +1,18 @@
+#ifndef COLORING_ORDER_H
+#define COLORING_ORDER_H
+
+#include "graph.h"
+
+// Порядки обхода для жадной раскраски (order - num_vertices - 1 вершин 1 .. n - 1),
+// оба строятся сортировкой подсчётом по степени за O(V + E) по CSR-графу.
+// Наибольшая степень первой (Welsh-Powell); при равенстве - меньший номер.
+// Возвращает 0 при нехватке памяти.
+int largest_first_order(const Graph* csr, int* order);
+// Наименьшая последней (Matula-Beck): вершина наименьшей текущей степени
+// убирается из графа, порядок - обратный порядку удаления. Каждая вершина
+// при раскраске имеет не больше *degeneracy уже раскрашенных соседей,
+// поэтому жадный алгоритм тратит не больше *degeneracy + 1 цветов
+// (у планарных графов вырожденность не больше 5).
+int smallest_last_order(const Graph* csr, int* order, int* degeneracy);
+
+#endif // COLORING_ORDER_H
\ No newline at end of file
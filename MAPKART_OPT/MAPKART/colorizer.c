@@ -1,24 +1,68 @@
 #include "colorizer.h"
+#include "dsatur.h"
+#include "kempe.h"
+#include "components.h"
+#include "exact_coloring.h"
+#include "parallel.h"
+#include "parallel_coloring.h"
+#include "peeling.h"
+#include "coloring_order.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 
-// Структура для сортировки вершин по степени
+static FILE* log_file = NULL;
+
+// Записи лога одной параллельной задачи: копятся в памяти и выводятся
+// в файл по порядку задач, чтобы записи разных потоков не перемешивались
 typedef struct {
-    int vertex;
-    int degree;
-} VertexDegree;
+    char* data;
+    size_t length;
+    size_t capacity;
+    int truncated; // Часть записей потеряна из-за нехватки памяти
+} LogBuffer;
+
+// Если не NULL, log_message() текущего потока пишет в этот буфер
+static _Thread_local LogBuffer* thread_log_buffer = NULL;
 
-// Функция сравнения для qsort (по убыванию степени)
-static int compare_vertex_degree(const void* a, const void* b) {
-    const VertexDegree* va = (const VertexDegree*)a;
-    const VertexDegree* vb = (const VertexDegree*)b;
-    return vb->degree - va->degree; // Убывание
+static void log_buffer_append(LogBuffer* buffer, const char* format, va_list args) {
+    va_list measure;
+    va_copy(measure, args);
+    int length = vsnprintf(NULL, 0, format, measure);
+    va_end(measure);
+    if (length < 0) return;
+    if (buffer->length + length + 1 > buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity * 2 : 4096;
+        while (capacity < buffer->length + length + 1) capacity *= 2;
+        char* data = (char*)realloc(buffer->data, capacity);
+        if (!data) {
+            buffer->truncated = 1;
+            return;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+    vsnprintf(buffer->data + buffer->length, length + 1, format, args);
+    buffer->length += length;
 }
 
-static FILE* log_file = NULL;
+// Выводит накопленные записи в лог и освобождает буфер
+static void flush_log_buffer(LogBuffer* buffer) {
+    if (log_file && buffer->length > 0) {
+        fwrite(buffer->data, 1, buffer->length, log_file);
+    }
+    if (log_file && buffer->truncated) {
+        fprintf(log_file, "(some log lines were lost: out of memory)\n");
+    }
+    if (log_file) fflush(log_file);
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+}
 
 void init_logging(const char* log_filename) {
     log_file = fopen(log_filename, "w");
@@ -50,186 +94,310 @@ void log_message(const char* format, ...) {
     if (log_file) {
         va_list args;
         va_start(args, format);
-        vfprintf(log_file, format, args);
-        va_end(args);
-        fflush(log_file);
-    }
-}
-
-// Оптимизированная функция вычисления степени
-// Индуктивная переменная: начинаем с 1
-static inline int get_degree(Graph* graph, int vertex) {
-    int degree = 0;
-    int num_v = graph->num_vertices;
-    int* row = graph->matrix[vertex]; // Снижение мощности - один раз получаем указатель
-    
-    // Оптимизация: для малых графов простая проверка быстрее
-    if (num_v <= 8) {
-        for (int i = 1; i < num_v; i++) {
-            degree += row[i];
-        }
-        return degree;
-    }
-    
-    // Развертка цикла для лучшей производительности (для больших графов)
-    int i = 1;
-    int end = num_v - 3; // Для развертки
-    for (; i < end; i += 4) {
-        degree += row[i] + row[i+1] + row[i+2] + row[i+3];
-    }
-    // Обработка оставшихся элементов
-    for (; i < num_v; i++) {
-        degree += row[i];
-    }
-    return degree;
-}
-
-// Оптимизированная проверка безопасности цвета
-// Ранний выход при первом конфликте
-static inline int is_color_safe(Graph* graph, int vertex, int color, int* result_colors) {
-    int num_v = graph->num_vertices;
-    int* row = graph->matrix[vertex]; // Снижение мощности
-    
-    // Оптимизация: для малых графов простая проверка быстрее
-    if (num_v <= 8) {
-        for (int i = 1; i < num_v; i++) {
-            // Оптимизация: проверяем сначала наличие ребра, потом цвет (short-circuit)
-            if (row[i] && result_colors[i] == color) {
-                return 0; // Ранний выход при конфликте
-            }
-        }
-        return 1;
-    }
-    
-    // Развертка цикла для ускорения (только если вершин достаточно)
-    int i = 1;
-    int end = num_v - 3;
-    for (; i < end; i += 4) {
-        // Оптимизация: проверяем все 4 элемента за одну итерацию
-        // Используем short-circuit evaluation для раннего выхода
-        if (row[i] && result_colors[i] == color) return 0;
-        if (row[i+1] && result_colors[i+1] == color) return 0;
-        if (row[i+2] && result_colors[i+2] == color) return 0;
-        if (row[i+3] && result_colors[i+3] == color) return 0;
-    }
-    // Обработка оставшихся элементов
-    for (; i < num_v; i++) {
-        if (row[i] && result_colors[i] == color) {
-            return 0;
+        if (thread_log_buffer) {
+            log_buffer_append(thread_log_buffer, format, args);
+        } else {
+            vfprintf(log_file, format, args);
+            fflush(log_file);
         }
+        va_end(args);
     }
-    return 1;
 }
 
-int* color_graph(Graph* graph, int* num_colors) {
-    log_message("STEP 1: Starting graph coloring process\n");
-    log_message("=====================================\n");
-    
-    int num_vertices = graph->num_vertices;
-    log_message("Total vertices in graph: %d\n", num_vertices);
-    
-    int* result_colors = (int*)malloc(num_vertices * sizeof(int));
-    
-    for (int i = 0; i < num_vertices; i++) {
-        result_colors[i] = 0;
+// Жадная раскраска: вершины в порядке движка (Welsh-Powell - по убыванию
+// степени, smallest-last - обратный порядку вырождения), каждой - наименьший
+// свободный цвет. Степени и порядок берутся из CSR-представления за O(V + E).
+// Вершины без безопасного цвета остаются с цветом 0 и попадают в uncolored.
+// Возвращает их число или -1 при нехватке памяти.
+static int color_greedy(const Graph* csr, ColoringEngine engine, int* result_colors, int* uncolored) {
+    int num_vertices = csr->num_vertices;
+    int* vertices_by_degree = (int*)malloc(num_vertices * sizeof(int));
+    if (!vertices_by_degree) {
+        return -1;
     }
-
-    int* vertices_by_degree = (int*)malloc((num_vertices - 1) * sizeof(int));
-    int* degrees = (int*)malloc((num_vertices - 1) * sizeof(int));
     
     log_message("\nSTEP 2: Calculating vertex degrees\n");
     log_message("==================================\n");
     
     for (int i = 1; i < num_vertices; i++) {
-        vertices_by_degree[i - 1] = i;
-        degrees[i - 1] = get_degree(graph, i);
-        log_message("Vertex %d: degree = %d\n", i, degrees[i - 1]);
-    }
-    
-    log_message("\nSTEP 3: Sorting vertices by degree (descending)\n");
-    log_message("==============================================\n");
-    
-    // Оптимизация: использование qsort вместо bubble sort
-    // O(V log V) вместо O(V²)
-    VertexDegree* vd_array = (VertexDegree*)malloc((num_vertices - 1) * sizeof(VertexDegree));
-    for (int i = 0; i < num_vertices - 1; i++) {
-        vd_array[i].vertex = vertices_by_degree[i];
-        vd_array[i].degree = degrees[i];
+        log_message("Vertex %d: degree = %d\n", i, csr->offsets[i + 1] - csr->offsets[i]);
     }
     
-    qsort(vd_array, num_vertices - 1, sizeof(VertexDegree), compare_vertex_degree);
-    
-    // Восстанавливаем массивы из отсортированной структуры
-    for (int i = 0; i < num_vertices - 1; i++) {
-        vertices_by_degree[i] = vd_array[i].vertex;
-        degrees[i] = vd_array[i].degree;
+    if (engine == COLORING_SMALLEST_LAST) {
+        log_message("\nSTEP 3: Smallest-last ordering (bucket queue by degree)\n");
+        log_message("======================================================\n");
+        int degeneracy = 0;
+        if (!smallest_last_order(csr, vertices_by_degree, &degeneracy)) {
+            free(vertices_by_degree);
+            return -1;
+        }
+        log_message("Degeneracy: %d (greedy uses at most %d colors)\n", degeneracy, degeneracy + 1);
+    } else {
+        log_message("\nSTEP 3: Sorting vertices by degree (descending)\n");
+        log_message("==============================================\n");
+        // Сортировка подсчётом по степени: O(V + E) вместо qsort
+        if (!largest_first_order(csr, vertices_by_degree)) {
+            free(vertices_by_degree);
+            return -1;
+        }
     }
-    free(vd_array);
     
-    log_message("Sorted order (by degree): ");
+    log_message("Order (vertex(degree)): ");
     for (int i = 0; i < num_vertices - 1; i++) {
-        log_message("%d(%d) ", vertices_by_degree[i], degrees[i]);
+        int v = vertices_by_degree[i];
+        log_message("%d(%d) ", v, csr->offsets[v + 1] - csr->offsets[v]);
     }
     log_message("\n");
     
-    int max_color = 0;
+    int num_uncolored = 0;
     const int MAX_COLORS = 4;
     
-    log_message("\nSTEP 4: Coloring vertices using Welsh-Powell algorithm\n");
-    log_message("=====================================================\n");
+    // Маска цветов, уже занятых соседями (бит c - 1 - цвет c): обновляется
+    // один раз при раскраске соседа, поэтому цвет выбирается без повторных
+    // просмотров соседей, а весь проход - O(V + E)
+    unsigned char* forbidden = (unsigned char*)calloc(num_vertices, 1);
+    if (!forbidden) {
+        free(vertices_by_degree);
+        return -1;
+    }
+    const unsigned all_colors = (1u << MAX_COLORS) - 1;
+    
+    log_message("\nSTEP 4: Coloring vertices greedily in the chosen order\n");
+    log_message("======================================================\n");
     log_message("Maximum colors allowed: %d\n", MAX_COLORS);
     
-    // Оптимизация: развертка цикла для MAX_COLORS=4
     // Индуктивная переменная: предвычисление vertex
     int num_v_minus_1 = num_vertices - 1;
     
     for (int i = 0; i < num_v_minus_1; i++) {
         int vertex = vertices_by_degree[i];
         
-        log_message("\nProcessing vertex %d (degree %d):\n", vertex, degrees[i]);
-        
-        // Развертка цикла для 4 цветов (MAX_COLORS = 4)
-        // Оптимизация: проверяем цвета последовательно с ранним выходом
-        // Цвет 1
-        if (is_color_safe(graph, vertex, 1, result_colors)) {
-            result_colors[vertex] = 1;
-            if (max_color < 1) max_color = 1;
-            log_message("  -> Assigned color 1 (safe)\n");
-            continue; // Переход к следующей вершине
-        }
-        log_message("  -> Color 1 not safe (conflicts with adjacent vertices)\n");
+        log_message("\nProcessing vertex %d (degree %d):\n", vertex, csr->offsets[vertex + 1] - csr->offsets[vertex]);
         
-        // Цвет 2
-        if (is_color_safe(graph, vertex, 2, result_colors)) {
-            result_colors[vertex] = 2;
-            if (max_color < 2) max_color = 2;
-            log_message("  -> Assigned color 2 (safe)\n");
+        // Наименьший свободный цвет - младший нулевой бит маски
+        unsigned free_colors = ~forbidden[vertex] & all_colors;
+        if (!free_colors) {
+            // Вершина без свободного цвета дораскрашивается после прохода (repair_coloring)
+            log_message("  -> No safe color (neighbors use 1-%d), deferred to Kempe chain repair\n", MAX_COLORS);
+            uncolored[num_uncolored++] = vertex;
             continue;
         }
-        log_message("  -> Color 2 not safe (conflicts with adjacent vertices)\n");
+        int color = lowest_bit_index(free_colors) + 1;
+        result_colors[vertex] = color;
+        log_message("  -> Assigned color %d (neighbor color mask 0x%x)\n", color, forbidden[vertex]);
         
-        // Цвет 3
-        if (is_color_safe(graph, vertex, 3, result_colors)) {
-            result_colors[vertex] = 3;
-            if (max_color < 3) max_color = 3;
-            log_message("  -> Assigned color 3 (safe)\n");
-            continue;
+        unsigned char bit = (unsigned char)(1u << (color - 1));
+        for (int k = csr->offsets[vertex]; k < csr->offsets[vertex + 1]; k++) {
+            forbidden[csr->neighbors[k]] |= bit;
         }
-        log_message("  -> Color 3 not safe (conflicts with adjacent vertices)\n");
-        
-        // Цвет 4
-        if (is_color_safe(graph, vertex, 4, result_colors)) {
-            result_colors[vertex] = 4;
-            max_color = 4; // Максимальный цвет
-            log_message("  -> Assigned color 4 (safe)\n");
-            continue;
+    }
+    
+    free(vertices_by_degree);
+    free(forbidden);
+    return num_uncolored;
+}
+
+// DSATUR по CSR-представлению графа (см. color_greedy)
+static int color_dsatur(const Graph* csr, int* result_colors, int* uncolored) {
+    const int MAX_COLORS = 4;
+    log_message("\nSTEP 2-4: Coloring vertices using DSATUR\n");
+    log_message("=======================================\n");
+    log_message("Maximum colors allowed: %d\n", MAX_COLORS);
+    int num_uncolored = 0;
+    if (dsatur_color(csr, MAX_COLORS, result_colors, uncolored, &num_uncolored) < 0) return -1;
+    return num_uncolored;
+}
+
+// Jones-Plassmann на num_threads потоках (см. color_greedy)
+static int color_jones_plassmann(const Graph* csr, int num_threads, int* result_colors, int* uncolored) {
+    const int MAX_COLORS = 4;
+    log_message("\nSTEP 2-4: Coloring vertices in parallel (Jones-Plassmann)\n");
+    log_message("========================================================\n");
+    log_message("Maximum colors allowed: %d\n", MAX_COLORS);
+    int num_uncolored = 0;
+    if (jones_plassmann_color(csr, MAX_COLORS, num_threads, result_colors, uncolored, &num_uncolored) < 0) {
+        return -1;
+    }
+    return num_uncolored;
+}
+
+// Движок раскраски и ремонт для связного графа в его собственной нумерации.
+// Возвращает число вершин с неустранённым конфликтом или -1 при нехватке памяти.
+static int color_connected(const Graph* csr, ColoringEngine engine, int num_threads, int* colors) {
+    int* uncolored = (int*)malloc(csr->num_vertices * sizeof(int));
+    if (!uncolored) return -1;
+    int num_uncolored;
+    if (engine == COLORING_DSATUR) {
+        num_uncolored = color_dsatur(csr, colors, uncolored);
+    } else if (engine == COLORING_JONES_PLASSMANN) {
+        num_uncolored = color_jones_plassmann(csr, num_threads, colors, uncolored);
+    } else {
+        num_uncolored = color_greedy(csr, engine, colors, uncolored);
+    }
+    
+    int unresolved = num_uncolored;
+    if (num_uncolored > 0) {
+        log_message("\nSTEP 4b: Kempe chain repair of %d vertices\n", num_uncolored);
+        log_message("=========================================\n");
+        unresolved = repair_coloring(csr, 4, colors, uncolored, num_uncolored);
+        if (unresolved >= 0) {
+            log_message("Repaired: %d, still conflicting: %d\n", num_uncolored - unresolved, unresolved);
         }
-        log_message("  -> Color 4 not safe (conflicts with adjacent vertices)\n");
-        
-        // Fallback (не должно происходить с 4-цветной теоремой)
-        log_message("  -> WARNING: Could not color vertex %d with 4 colors! Using fallback.\n", vertex);
-        result_colors[vertex] = 1;
-        if (max_color == 0) max_color = 1;
+    }
+    free(uncolored);
+    return unresolved;
+}
+
+// Раскраска компонент графа: каждая - отдельным подграфом, по задаче на компоненту
+typedef struct {
+    const Graph* csr;
+    const GraphComponents* components;
+    ColoringEngine engine;
+    int engine_threads; // Потоки внутри одной компоненты (Jones-Plassmann)
+    int* colors;        // В нумерации csr
+    int* local_index;   // Общий для компонент, см. component_subgraph()
+    LogBuffer* logs;    // Записи лога каждой компоненты (NULL без лога)
+    atomic_int failed;
+} ComponentColoring;
+
+static void color_component_task(void* context, int c) {
+    ComponentColoring* job = (ComponentColoring*)context;
+    const int* vertices = job->components->vertices + job->components->start[c];
+    int count = job->components->start[c + 1] - job->components->start[c];
+    // Одиночная вершина: движок и подграф не нужны
+    if (count == 1) {
+        job->colors[vertices[0]] = 1;
+        return;
+    }
+    if (job->logs) thread_log_buffer = &job->logs[c];
+    log_message("\nComponent %d: %d vertices\n", c + 1, count);
+    Graph* subgraph = component_subgraph(job->csr, job->components, c, job->local_index);
+    int* colors = subgraph ? (int*)calloc(count + 1, sizeof(int)) : NULL;
+    int unresolved = colors ? color_connected(subgraph, job->engine, job->engine_threads, colors) : -1;
+    if (unresolved < 0) {
+        atomic_store(&job->failed, 1);
+    } else {
+        for (int i = 0; i < count; i++) {
+            job->colors[vertices[i]] = colors[i + 1];
+        }
+    }
+    free(colors);
+    free_graph(subgraph);
+    thread_log_buffer = NULL;
+}
+
+// Раскрашивает csr по компонентам связности: компоненты независимы, поэтому
+// красятся параллельно, крупные - первыми (задачи разбираются по порядку).
+// Записи лога компонент копятся по задачам и выводятся по порядку компонент.
+// Возвращает 1 или 0 при нехватке памяти.
+static int color_components(const Graph* csr, const ColoringOptions* options, int* colors) {
+    GraphComponents* components = find_components(csr);
+    if (!components) return 0;
+    int count = components->num_components;
+    log_message("\nSTEP 1c: Connected components\n");
+    log_message("=============================\n");
+    log_message("Components: %d, largest: %d vertices\n", count,
+                count > 0 ? components->start[1] - components->start[0] : 0);
+    
+    ComponentColoring job;
+    job.csr = csr;
+    job.components = components;
+    job.engine = options->engine;
+    job.engine_threads = count == 1 ? options->num_threads : 1;
+    job.colors = colors;
+    job.local_index = (int*)malloc(csr->num_vertices * sizeof(int));
+    job.logs = log_file && count > 1 ? (LogBuffer*)calloc(count, sizeof(LogBuffer)) : NULL;
+    atomic_init(&job.failed, job.local_index == NULL);
+    if (count == 1) {
+        // Одна компонента - это весь граф, копия не нужна
+        if (color_connected(csr, options->engine, options->num_threads, colors) < 0) {
+            atomic_store(&job.failed, 1);
+        }
+    } else if (job.local_index) {
+        // Без буферов лога (нехватка памяти) - по одной компоненте
+        parallel_for(count, log_file && !job.logs ? 1 : options->num_threads, color_component_task, &job);
+    }
+    if (job.logs) {
+        for (int c = 0; c < count; c++) {
+            flush_log_buffer(&job.logs[c]);
+        }
+        free(job.logs);
+    }
+    int ok = !atomic_load(&job.failed);
+    free(job.local_index);
+    free_graph_components(components);
+    return ok;
+}
+
+int* color_graph(Graph* graph, const ColoringOptions* options, ColoringSummary* summary) {
+    log_message("STEP 1: Starting graph coloring process\n");
+    log_message("=====================================\n");
+    
+    int num_vertices = graph->num_vertices;
+    log_message("Total vertices in graph: %d\n", num_vertices);
+    static const char* engine_names[] = {"smallest-last", "Welsh-Powell", "DSATUR", "Jones-Plassmann"};
+    log_message("Coloring engine: %s\n", engine_names[options->engine]);
+    
+    int* result_colors = (int*)calloc(num_vertices, sizeof(int));
+    // Все движки работают по спискам соседей (для матриц - временная CSR-копия)
+    Graph* owned = NULL;
+    const Graph* csr = graph_csr_view(graph, &owned);
+    summary->proven_optimal = 0;
+    
+    // Точный режим: наименьшее число цветов перебором по компонентам;
+    // если 4 цветов не нашлось за отведённое время - обычная раскраска ниже
+    int exact_colors = 0;
+    if (csr && result_colors && options->exact_time_budget > 0) {
+        log_message("\nSTEP 1a: Exact minimum coloring (budget %.2f seconds)\n",
+                    options->exact_time_budget);
+        log_message("=====================================================================\n");
+        exact_colors = exact_color_graph(csr, 4, options->exact_time_budget, options->num_threads,
+                                         result_colors, &summary->proven_optimal);
+        if (exact_colors > 0) {
+            log_message("Exact coloring: %d colors, optimality %s\n", exact_colors,
+                        summary->proven_optimal ? "proven" : "not proven");
+        } else if (exact_colors == 0) {
+            log_message("No 4-coloring found, falling back to heuristic coloring\n");
+        }
+    }
+    
+    // Вершины степени меньше 4 снимаются заранее, и движок с ремонтом
+    // работают только по ядру (в своей нумерации вершин 1 .. k)
+    PeeledGraph* peeled = NULL;
+    const Graph* target = csr;
+    int* target_colors = result_colors;
+    if (exact_colors != 0) {
+        target = NULL; // Раскраска уже готова (или нехватка памяти)
+    } else if (csr && options->peel_low_degree) {
+        log_message("\nSTEP 1b: Peeling vertices of degree < 4\n");
+        log_message("========================================\n");
+        peeled = peel_low_degree(csr, 4);
+        target = peeled ? peeled->core : NULL;
+        target_colors = target ? (int*)calloc(target->num_vertices, sizeof(int)) : NULL;
+    }
+    int ok = exact_colors > 0 ||
+             (result_colors && target && target_colors && color_components(target, options, target_colors));
+    
+    if (peeled && ok) {
+        log_message("\nSTEP 4c: Coloring %d peeled vertices in reverse order\n", peeled->num_peeled);
+        log_message("=====================================================\n");
+        for (int i = 1; i < target->num_vertices; i++) {
+            result_colors[peeled->core_vertices[i]] = target_colors[i];
+        }
+        color_peeled_vertices(csr, peeled, 4, result_colors);
+    }
+    if (target_colors != result_colors) free(target_colors);
+    free_peeled_graph(peeled);
+    free_graph(owned);
+    if (!ok) {
+        fprintf(stderr, "Failed to color graph.\n");
+        free(result_colors);
+        return NULL;
+    }
+    
+    int max_color = 0;
+    for (int i = 1; i < num_vertices; i++) {
+        if (result_colors[i] > max_color) max_color = result_colors[i];
     }
     
     log_message("\nSTEP 5: Coloring results summary\n");
@@ -240,109 +408,181 @@ int* color_graph(Graph* graph, int* num_colors) {
     }
     log_message("\nTotal colors used: %d\n", max_color);
     
-    free(vertices_by_degree);
-    free(degrees);
-    
-    *num_colors = max_color;
+    summary->num_colors = max_color;
     return result_colors;
 }
 
 
-void apply_colors_to_image(BMPImage* image, int* region_map, int* colors) {
-    log_message("\nSTEP 6: Applying colors to image\n");
-    log_message("=================================\n");
-    
-    int width = image->info_header.width;
-    int height = image->info_header.height;
-    log_message("Image dimensions: %d x %d pixels\n", width, height);
+static const Pixel color_palette[] = {
+        {0, 0, 0},       // 0 - Black (unused/borders)
+        {255, 0, 0},     // 1 - Red
+        {0, 255, 0},     // 2 - Green
+        {0, 0, 255},     // 3 - Blue
+        {0, 255, 255},   // 4 - Yellow
+};
 
-    Pixel color_palette[] = {
-            {0, 0, 0},       // 0 - Black (unused/borders)
-            {255, 0, 0},     // 1 - Red
-            {0, 255, 0},     // 2 - Green
-            {0, 0, 255},     // 3 - Blue
-            {0, 255, 255},   // 4 - Yellow
-    };
-    int palette_size = sizeof(color_palette) / sizeof(Pixel);
-    
+static void log_color_palette() {
     log_message("Color palette:\n");
     log_message("  Color 0: Black (borders)\n");
     log_message("  Color 1: Red (255, 0, 0)\n");
     log_message("  Color 2: Green (0, 255, 0)\n");
     log_message("  Color 3: Blue (0, 0, 255)\n");
     log_message("  Color 4: Yellow (255, 255, 0)\n");
+}
+
+void apply_colors_to_image(BMPImage* image, const ForegroundMask* mask, int* region_map, int* colors) {
+    log_message("\nSTEP 6: Applying colors to image\n");
+    log_message("=================================\n");
+    
+    int width = image->info_header.width;
+    int height = image->info_header.height;
+    log_message("Image dimensions: %d x %d pixels\n", width, height);
+
+    log_color_palette();
     
     int colored_pixels = 0;
     int border_pixels = 0;
     
-    // Оптимизация: индуктивная переменная, снижение мощности
-    int total_pixels = width * height;
     Pixel black_pixel = {0, 0, 0}; // Предвычисление
     
     // Оптимизация: кэшируем указатели для быстрого доступа
     Pixel* image_data = image->data;
     
-    // Развертка цикла для лучшей производительности (обрабатываем по 4 пикселя)
-    int i = 0;
-    int end = total_pixels - 3;
-    for (; i < end; i += 4) {
-        // Пиксель 0
-        int region_id0 = region_map[i];
-        if (region_id0 > 0) {
-            int color_id0 = colors[region_id0];
-            // Оптимизация: убираем проверку диапазона (цвета всегда валидны после раскраски)
-            image_data[i] = color_palette[color_id0];
-            colored_pixels++;
-        } else {
-            image_data[i] = black_pixel;
-            border_pixels++;
-        }
-        
-        // Пиксель 1
-        int region_id1 = region_map[i+1];
-        if (region_id1 > 0) {
-            image_data[i+1] = color_palette[colors[region_id1]];
-            colored_pixels++;
-        } else {
-            image_data[i+1] = black_pixel;
-            border_pixels++;
+    // Оптимизация: граница определяется по битовой маске, region_map читается
+    // только для белых пикселей, а слова маски из одних нулей (64 пикселя
+    // границы подряд) заливаются чёрным без проверок
+    for (int y = 0; y < height; y++) {
+        const uint64_t* mask_words = mask_row(mask, y);
+        Pixel* row_pixels = image_data + y * width;
+        int* row_regions = region_map + y * width;
+        for (int w = 0; w < mask->words_per_row; w++) {
+            int x_begin = w << 6;
+            int x_end = x_begin + 64 < width ? x_begin + 64 : width;
+            uint64_t word = mask_words[w];
+            
+            if (word == 0) {
+                for (int x = x_begin; x < x_end; x++) {
+                    row_pixels[x] = black_pixel;
+                }
+                border_pixels += x_end - x_begin;
+                continue;
+            }
+            
+            for (int x = x_begin; x < x_end; x++) {
+                if ((word >> (x - x_begin)) & 1) {
+                    // Оптимизация: убираем проверку диапазона (цвета всегда валидны после раскраски)
+                    row_pixels[x] = color_palette[colors[row_regions[x]]];
+                } else {
+                    row_pixels[x] = black_pixel;
+                }
+            }
+            int white = bit_count(word);
+            colored_pixels += white;
+            border_pixels += (x_end - x_begin) - white;
         }
-        
-        // Пиксель 2
-        int region_id2 = region_map[i+2];
-        if (region_id2 > 0) {
-            image_data[i+2] = color_palette[colors[region_id2]];
-            colored_pixels++;
-        } else {
-            image_data[i+2] = black_pixel;
-            border_pixels++;
+    }
+    
+    log_message("\nPixel statistics:\n");
+    log_message("  Colored pixels: %d\n", colored_pixels);
+    log_message("  Border pixels: %d\n", border_pixels);
+    log_message("  Total pixels: %d\n", width * height);
+}
+
+void apply_colors_rle(BMPImage* image, const RunLengthMap* rle, int* colors) {
+    log_message("\nSTEP 6: Applying colors to image\n");
+    log_message("=================================\n");
+    
+    int width = image->info_header.width;
+    int height = image->info_header.height;
+    log_message("Image dimensions: %d x %d pixels\n", width, height);
+    log_color_palette();
+    
+    long colored_pixels = 0;
+    Pixel black_pixel = {0, 0, 0}; // Предвычисление
+    Pixel* image_data = image->data;
+    
+    // Оптимизация: номер региона читается один раз на отрезок, а не на пиксель
+    for (int y = 0; y < height; y++) {
+        Pixel* row_pixels = image_data + y * width;
+        int x = 0;
+        for (int i = rle->row_start[y]; i < rle->row_start[y + 1]; i++) {
+            const LabelRun* run = &rle->runs[i];
+            for (; x < run->start; x++) {
+                row_pixels[x] = black_pixel;
+            }
+            Pixel color = color_palette[colors[run->label]];
+            int end = run->start + run->length;
+            for (; x < end; x++) {
+                row_pixels[x] = color;
+            }
+            colored_pixels += run->length;
         }
-        
-        // Пиксель 3
-        int region_id3 = region_map[i+3];
-        if (region_id3 > 0) {
-            image_data[i+3] = color_palette[colors[region_id3]];
-            colored_pixels++;
-        } else {
-            image_data[i+3] = black_pixel;
-            border_pixels++;
+        for (; x < width; x++) {
+            row_pixels[x] = black_pixel;
         }
     }
     
-    // Обработка оставшихся пикселей
-    for (; i < total_pixels; i++) {
-        int region_id = region_map[i];
-        if (region_id > 0) {
-            image_data[i] = color_palette[colors[region_id]];
-            colored_pixels++;
-        } else {
-            image_data[i] = black_pixel;
-            border_pixels++;
+    log_message("\nPixel statistics:\n");
+    log_message("  Colored pixels: %ld\n", colored_pixels);
+    log_message("  Border pixels: %ld\n", (long)width * height - colored_pixels);
+    log_message("  Total pixels: %d\n", width * height);
+}
+
+int write_colored_bmp_streamed(const char* filename, StreamedRegions* regions, int* colors) {
+    log_message("\nSTEP 6: Applying colors to image (streaming)\n");
+    log_message("=============================================\n");
+    
+    int width = regions->width;
+    int height = regions->height;
+    log_message("Image dimensions: %d x %d pixels\n", width, height);
+    log_color_palette();
+    
+    BMPStream* output = bmp_open_write(filename, &regions->header, &regions->info_header);
+    if (!output) {
+        return 0;
+    }
+    Pixel* row_pixels = (Pixel*)malloc(width * sizeof(Pixel));
+    if (!row_pixels) {
+        bmp_close(output);
+        return 0;
+    }
+    
+    long colored_pixels = 0;
+    Pixel black_pixel = {0, 0, 0}; // Предвычисление
+    int ok = 1;
+    
+    // Выходное изображение собирается строка за строкой прямо из отрезков
+    for (int y = 0; y < height && ok; y++) {
+        const LabelRun* runs;
+        int count = streamed_read_row(regions, y, &runs);
+        if (count < 0) {
+            ok = 0;
+            break;
+        }
+        int x = 0;
+        for (int i = 0; i < count; i++) {
+            for (; x < runs[i].start; x++) {
+                row_pixels[x] = black_pixel;
+            }
+            Pixel color = color_palette[colors[runs[i].label]];
+            int end = runs[i].start + runs[i].length;
+            for (; x < end; x++) {
+                row_pixels[x] = color;
+            }
+            colored_pixels += runs[i].length;
         }
+        for (; x < width; x++) {
+            row_pixels[x] = black_pixel;
+        }
+        ok = bmp_write_row(output, row_pixels);
     }
     
+    free(row_pixels);
+    ok = bmp_close(output) && ok;
+    
     log_message("\nPixel statistics:\n");
-    log_message("  Colored pixels: %d\n", colored_pixels);
-    log_message("  Border pixels: %d\n", border_pixels);
-    log_message("  Total pixels: %d\n", width * height);
+    log_message("  Colored pixels: %ld\n", colored_pixels);
+    log_message("  Border pixels: %ld\n", (long)width * height - colored_pixels);
+    log_message("  Total pixels: %ld\n", (long)width * height);
+    return ok;
 }
\ No newline at end of file
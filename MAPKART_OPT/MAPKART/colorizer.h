@@ -9,8 +9,33 @@ void init_logging(const char* log_filename);
 void close_logging();
 void log_message(const char* format, ...);
 
+// Алгоритм раскраски
+typedef enum {
+    COLORING_SMALLEST_LAST = 0, // Жадная раскраска в порядке вырождения (не больше 6 цветов на планарном графе)
+    COLORING_WELSH_POWELL,      // Жадная раскраска по убыванию степени
+    COLORING_DSATUR,            // По наибольшей насыщенности (см. dsatur.h)
+    COLORING_JONES_PLASSMANN    // Параллельно, раундами независимых множеств (см. parallel_coloring.h)
+} ColoringEngine;
+
+typedef struct {
+    ColoringEngine engine;
+    int num_threads; // Потоки для COLORING_JONES_PLASSMANN
+    int peel_low_degree; // Снимать вершины степени < 4 и красить движком только ядро (см. peeling.h)
+    double exact_time_budget; // > 0 - точная минимальная раскраска, секунды на весь поиск (см. exact_coloring.h)
+} ColoringOptions;
+
+// Итог раскраски
+typedef struct {
+    int num_colors;
+    int proven_optimal; // Точный режим: доказано, что меньше цветов не хватит
+} ColoringSummary;
+
 // Main coloring functions
-int* color_graph(Graph* graph, int* num_colors);
-void apply_colors_to_image(BMPImage* image, int* region_map, int* colors);
+// Возвращает цвета вершин (1..4, 0 - вершина 0) или NULL при нехватке памяти
+int* color_graph(Graph* graph, const ColoringOptions* options, ColoringSummary* summary);
+void apply_colors_to_image(BMPImage* image, const ForegroundMask* mask, int* region_map, int* colors);
+void apply_colors_rle(BMPImage* image, const RunLengthMap* rle, int* colors);
+// Записывает раскрашенное изображение построчно, не держа его в памяти целиком
+int write_colored_bmp_streamed(const char* filename, StreamedRegions* regions, int* colors);
 
 #endif // COLORIZER_H
\ No newline at end of file
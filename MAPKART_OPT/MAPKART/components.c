@@ -0,0 +1,147 @@
+#include "components.h"
+#include <stdio.h>
+
+// Корень множества с сокращением пути вдвое
+static int uf_find(int* parent, int v) {
+    while (parent[v] != v) {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    return v;
+}
+
+GraphComponents* find_components(const Graph* csr) {
+    int n = csr->num_vertices;
+    GraphComponents* result = (GraphComponents*)calloc(1, sizeof(GraphComponents));
+    int* parent = (int*)malloc(n * sizeof(int));
+    int* size = (int*)malloc(n * sizeof(int));
+    int* label = (int*)malloc(n * sizeof(int));
+    int* rank = (int*)malloc(n * sizeof(int));
+    int* bin = (int*)calloc(n + 1, sizeof(int));
+    if (result) {
+        result->start = (int*)malloc((n + 1) * sizeof(int));
+        result->vertices = (int*)malloc(n * sizeof(int));
+    }
+    if (!result || !parent || !size || !label || !rank || !bin || !result->start || !result->vertices) {
+        fprintf(stderr, "Failed to allocate memory for graph components.\n");
+        free(parent);
+        free(size);
+        free(label);
+        free(rank);
+        free(bin);
+        free_graph_components(result);
+        return NULL;
+    }
+
+    // Объединение по размеру: меньшее дерево подвешивается к большему
+    for (int v = 0; v < n; v++) {
+        parent[v] = v;
+        size[v] = 1;
+        label[v] = -1;
+    }
+    for (int v = 1; v < n; v++) {
+        for (int k = csr->offsets[v]; k < csr->offsets[v + 1]; k++) {
+            int u = csr->neighbors[k];
+            if (u < v) continue;
+            int a = uf_find(parent, v);
+            int b = uf_find(parent, u);
+            if (a == b) continue;
+            if (size[a] < size[b]) {
+                int t = a;
+                a = b;
+                b = t;
+            }
+            parent[b] = a;
+            size[a] += size[b];
+        }
+    }
+
+    // Номера компонент - в порядке их наименьших вершин (номер хранится у
+    // корня, затем переносится на все вершины); size[c] - размер компоненты c
+    int count = 0;
+    for (int v = 1; v < n; v++) {
+        int root = uf_find(parent, v);
+        if (label[root] < 0) {
+            label[root] = count++;
+        }
+        rank[v] = label[root];
+    }
+    for (int c = 0; c < count; c++) {
+        size[c] = 0;
+    }
+    for (int v = 1; v < n; v++) {
+        label[v] = rank[v];
+        size[label[v]]++;
+    }
+
+    // Устойчивая сортировка подсчётом по убыванию размера: rank[c] - место компоненты c
+    for (int c = 0; c < count; c++) {
+        bin[n - size[c]]++;
+    }
+    for (int i = 0, sum = 0; i <= n; i++) {
+        int t = bin[i];
+        bin[i] = sum;
+        sum += t;
+    }
+    for (int c = 0; c < count; c++) {
+        rank[c] = bin[n - size[c]]++;
+    }
+    result->num_components = count;
+    result->start[0] = 0;
+    for (int c = 0; c < count; c++) {
+        result->start[rank[c] + 1] = size[c];
+    }
+    for (int i = 0; i < count; i++) {
+        result->start[i + 1] += result->start[i];
+        bin[i] = result->start[i]; // Позиция записи следующей вершины компоненты
+    }
+    // Вершины раскладываются по возрастанию номеров
+    for (int v = 1; v < n; v++) {
+        result->vertices[bin[rank[label[v]]]++] = v;
+    }
+    free(parent);
+    free(size);
+    free(label);
+    free(rank);
+    free(bin);
+    return result;
+}
+
+Graph* component_subgraph(const Graph* csr, const GraphComponents* components, int c, int* local_index) {
+    const int* vertices = components->vertices + components->start[c];
+    int count = components->start[c + 1] - components->start[c];
+    int num_edges = 0;
+    for (int i = 0; i < count; i++) {
+        int v = vertices[i];
+        local_index[v] = i + 1;
+        num_edges += csr->offsets[v + 1] - csr->offsets[v];
+    }
+    num_edges /= 2;
+    // Номера в компоненте возрастают вместе с исходными, поэтому рёбра
+    // (u < v) получаются сразу упорядоченными
+    Edge* edges = (Edge*)malloc((num_edges + 1) * sizeof(Edge));
+    if (!edges) return NULL;
+    int e = 0;
+    for (int i = 0; i < count; i++) {
+        int v = vertices[i];
+        for (int k = csr->offsets[v]; k < csr->offsets[v + 1]; k++) {
+            int u = csr->neighbors[k];
+            if (u > v) {
+                edges[e].u = i + 1;
+                edges[e].v = local_index[u];
+                e++;
+            }
+        }
+    }
+    Graph* subgraph = create_graph_from_edges(count + 1, edges, num_edges, GRAPH_CSR);
+    free(edges);
+    return subgraph;
+}
+
+void free_graph_components(GraphComponents* components) {
+    if (components) {
+        free(components->start);
+        free(components->vertices);
+        free(components);
+    }
+}
\ No newline at end of file
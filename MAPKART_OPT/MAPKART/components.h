@@ -0,0 +1,25 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include "graph.h"
+
+// Связные компоненты графа по убыванию размера (при равенстве - по
+// наименьшему номеру вершины). Вершины компоненты c, по возрастанию номеров:
+// vertices[start[c]] .. vertices[start[c + 1] - 1]. Вершина 0 не входит.
+typedef struct {
+    int num_components;
+    int* start;    // num_components + 1 элементов
+    int* vertices; // num_vertices - 1 элементов
+} GraphComponents;
+
+// Компоненты графа csr (CSR) через систему непересекающихся множеств по
+// рёбрам. Возвращает NULL при нехватке памяти.
+GraphComponents* find_components(const Graph* csr);
+// Подграф компоненты c в виде CSR в нумерации 1 .. k (порядок vertices).
+// local_index - общий для всех компонент массив num_vertices элементов:
+// компоненты не пересекаются, поэтому подграфы разных компонент можно
+// строить одновременно. Возвращает NULL при нехватке памяти.
+Graph* component_subgraph(const Graph* csr, const GraphComponents* components, int c, int* local_index);
+void free_graph_components(GraphComponents* components);
+
+#endif // COMPONENTS_H
\ No newline at end of file
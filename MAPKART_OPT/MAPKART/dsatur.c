@@ -0,0 +1,90 @@
+#include "dsatur.h"
+#include <stdio.h>
+#include "colorizer.h"
+#include "saturation_queue.h"
+
+// Вершина с наибольшей насыщенностью, а среди них - с наибольшей степенью.
+// Насыщенность только растёт, поэтому указатели top поднимаются не выше
+// степени вставленной вершины, и суммарная работа поиска - O(V + E).
+static int queue_pop_max(SaturationQueue* queue, const int* saturation, const int* degrees) {
+    int vertex = saturation_queue_peek_max(queue);
+    if (vertex >= 0) saturation_queue_remove(queue, vertex, saturation[vertex], degrees[vertex]);
+    return vertex;
+}
+
+int dsatur_color(const Graph* csr, int max_colors, int* colors, int* uncolored, int* num_uncolored) {
+    int n = csr->num_vertices;
+    int max_degree = 0;
+    for (int v = 1; v < n; v++) {
+        int degree = csr->offsets[v + 1] - csr->offsets[v];
+        if (degree > max_degree) max_degree = degree;
+    }
+
+    SaturationQueue queue;
+    int queue_ok = saturation_queue_init(&queue, n, max_degree);
+    int* degrees = (int*)malloc(n * sizeof(int));
+    int* saturation = (int*)calloc(n, sizeof(int));
+    unsigned char* used = (unsigned char*)calloc(n, 1); // Маска цветов соседей, бит c - 1
+    unsigned char* in_queue = (unsigned char*)malloc(n);
+    if (!queue_ok || !degrees || !saturation || !used || !in_queue) {
+        fprintf(stderr, "Failed to allocate memory for DSATUR queue.\n");
+        saturation_queue_free(&queue);
+        free(degrees);
+        free(saturation);
+        free(used);
+        free(in_queue);
+        return -1;
+    }
+    colors[0] = 0;
+    in_queue[0] = 0;
+    for (int v = n - 1; v >= 1; v--) {
+        // Вставка в обратном порядке: при равных ключах первым выходит меньший номер
+        degrees[v] = csr->offsets[v + 1] - csr->offsets[v];
+        colors[v] = 0;
+        in_queue[v] = 1;
+        saturation_queue_insert(&queue, v, 0, degrees[v]);
+    }
+
+    const unsigned all_colors = (1u << max_colors) - 1;
+    int max_color = 0;
+    int uncolored_count = 0;
+    for (int step = 1; step < n; step++) {
+        int vertex = queue_pop_max(&queue, saturation, degrees);
+        in_queue[vertex] = 0;
+        unsigned free_colors = ~used[vertex] & all_colors;
+        if (!free_colors) {
+            log_message("  Vertex %d (saturation %d, degree %d): no free color\n",
+                        vertex, saturation[vertex], degrees[vertex]);
+            colors[vertex] = 0;
+            if (uncolored) uncolored[uncolored_count] = vertex;
+            uncolored_count++;
+            continue;
+        }
+        int color = lowest_bit_index(free_colors) + 1;
+        colors[vertex] = color;
+        if (color > max_color) max_color = color;
+        log_message("  Vertex %d (saturation %d, degree %d): color %d\n",
+                    vertex, saturation[vertex], degrees[vertex], color);
+
+        // Соседям без этого цвета в окружении насыщенность растёт на 1
+        unsigned bit = 1u << (color - 1);
+        for (int k = csr->offsets[vertex]; k < csr->offsets[vertex + 1]; k++) {
+            int u = csr->neighbors[k];
+            if (used[u] & bit) continue;
+            used[u] |= bit;
+            // Вершины, уже вынутые из очереди (в том числе оставшиеся без цвета), не двигаются
+            if (!in_queue[u]) continue;
+            saturation_queue_remove(&queue, u, saturation[u], degrees[u]);
+            saturation[u]++;
+            saturation_queue_insert(&queue, u, saturation[u], degrees[u]);
+        }
+    }
+
+    saturation_queue_free(&queue);
+    free(degrees);
+    free(saturation);
+    free(used);
+    free(in_queue);
+    if (num_uncolored) *num_uncolored = uncolored_count;
+    return max_color;
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#ifndef DSATUR_H
+#define DSATUR_H
+
+#include "graph.h"
+
+// Раскраска DSATUR: на каждом шаге красится вершина с наибольшим числом
+// различных цветов у соседей (насыщенностью), при равенстве - с наибольшей
+// степенью, в наименьший свободный цвет. Насыщенность хранится 4-битной маской
+// занятых цветов, вершины лежат в корзинах по ключу (насыщенность, степень),
+// поэтому вся раскраска занимает O(V + E).
+// csr - граф в виде CSR, colors - num_vertices элементов (заполняются).
+// Вершина без свободного цвета из max_colors (<= 4) получает 0 и попадает
+// в список uncolored (count - в *num_uncolored), если он не NULL.
+// Возвращает наибольший использованный цвет или -1 при нехватке памяти.
+int dsatur_color(const Graph* csr, int max_colors, int* colors, int* uncolored, int* num_uncolored);
+
+#endif // DSATUR_H
\ No newline at end of file
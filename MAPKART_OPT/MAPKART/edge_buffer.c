@@ -0,0 +1,71 @@
+#include "edge_buffer.h"
+#include <stdlib.h>
+#include <string.h>
+
+void init_edge_buffer(EdgeBuffer* buffer) {
+    buffer->keys = NULL;
+    buffer->count = 0;
+    buffer->capacity = 0;
+    buffer->last_key = 0; // Ключ (0, 0) не встречается: 0 - граница
+    buffer->failed = 0;
+}
+
+void free_edge_buffer(EdgeBuffer* buffer) {
+    free(buffer->keys);
+    buffer->keys = NULL;
+    buffer->count = 0;
+    buffer->capacity = 0;
+}
+
+int grow_edge_buffer(EdgeBuffer* buffer) {
+    int new_capacity = buffer->capacity ? buffer->capacity * 2 : 1024;
+    uint64_t* keys = (uint64_t*)realloc(buffer->keys, new_capacity * sizeof(uint64_t));
+    if (!keys) {
+        buffer->failed = 1;
+        return 0;
+    }
+    buffer->keys = keys;
+    buffer->capacity = new_capacity;
+    return 1;
+}
+
+int sort_unique_edge_keys(uint64_t* keys, int count) {
+    if (count <= 1) return count;
+    uint64_t* tmp = (uint64_t*)malloc(count * sizeof(uint64_t));
+    if (!tmp) return -1;
+
+    uint64_t* src = keys;
+    uint64_t* dst = tmp;
+    for (int shift = 0; shift < 64; shift += 8) {
+        int histogram[256];
+        memset(histogram, 0, sizeof(histogram));
+        for (int i = 0; i < count; i++) {
+            histogram[(src[i] >> shift) & 0xFF]++;
+        }
+        // Оптимизация: байт одинаков у всех ключей - проход ничего не меняет
+        if (histogram[(src[0] >> shift) & 0xFF] == count) continue;
+
+        int offset = 0;
+        for (int digit = 0; digit < 256; digit++) {
+            int bucket = histogram[digit];
+            histogram[digit] = offset;
+            offset += bucket;
+        }
+        for (int i = 0; i < count; i++) {
+            dst[histogram[(src[i] >> shift) & 0xFF]++] = src[i];
+        }
+        uint64_t* swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    // Удаление повторов с одновременным переносом результата в keys
+    int unique = 0;
+    for (int i = 0; i < count; i++) {
+        if (unique == 0 || src[i] != keys[unique - 1]) {
+            keys[unique++] = src[i];
+        }
+    }
+    free(tmp);
+    return unique;
+}
\ No newline at end of file
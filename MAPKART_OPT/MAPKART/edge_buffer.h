@@ -0,0 +1,50 @@
+#ifndef EDGE_BUFFER_H
+#define EDGE_BUFFER_H
+
+#include <stdint.h>
+
+// Буфер найденных касаний регионов (кандидатов в рёбра) одного потока.
+// Ребро u < v хранится одним ключом (u << 32) | v, поэтому порядок ключей
+// совпадает с порядком пар (u, v).
+typedef struct {
+    uint64_t* keys;
+    int count;
+    int capacity;
+    uint64_t last_key; // Вдоль общей границы касание повторяется подряд
+    int failed;        // Не хватило памяти
+} EdgeBuffer;
+
+static inline uint64_t edge_key(int u, int v) {
+    return ((uint64_t)(uint32_t)u << 32) | (uint32_t)v;
+}
+
+static inline int edge_key_u(uint64_t key) {
+    return (int)(key >> 32);
+}
+
+static inline int edge_key_v(uint64_t key) {
+    return (int)(uint32_t)key;
+}
+
+void init_edge_buffer(EdgeBuffer* buffer);
+void free_edge_buffer(EdgeBuffer* buffer);
+// Удваивает буфер; при нехватке памяти выставляет failed и возвращает 0
+int grow_edge_buffer(EdgeBuffer* buffer);
+
+// Добавляет касание регионов a != b
+static inline void edge_buffer_push(EdgeBuffer* buffer, int a, int b) {
+    uint64_t key = a < b ? edge_key(a, b) : edge_key(b, a);
+    // Оптимизация: подряд идущие повторы отсекаются до записи в буфер
+    if (key == buffer->last_key) return;
+    buffer->last_key = key;
+    if (buffer->count == buffer->capacity && !grow_edge_buffer(buffer)) return;
+    buffer->keys[buffer->count++] = key;
+}
+
+// Сортирует ключи поразрядной сортировкой (LSD, по байтам) и удаляет повторы.
+// Байты, одинаковые у всех ключей, пропускаются, поэтому число проходов
+// зависит от числа регионов, а не от ширины ключа.
+// Возвращает число различных ключей (в начале keys) или -1 при нехватке памяти.
+int sort_unique_edge_keys(uint64_t* keys, int count);
+
+#endif // EDGE_BUFFER_H
\ No newline at end of file
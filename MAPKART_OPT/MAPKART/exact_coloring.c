@@ -0,0 +1,311 @@
+#include "exact_coloring.h"
+#include "components.h"
+#include "peeling.h"
+#include "parallel.h"
+#include "saturation_queue.h"
+#include "colorizer.h"
+#include "utils.h"
+#include <stdatomic.h>
+#include <stdio.h>
+
+#define EXACT_CLIQUE_SEEDS 4096 // Вершин, от которых растится жадная клика
+#define EXACT_CHECK_NODES 1024  // Узлов перебора между проверками времени
+
+// Состояние перебора: счётчики соседей каждого цвета и их маски
+typedef struct {
+    const Graph* csr;
+    int k;
+    int* colors;
+    int* neighbor_count;        // 4 счётчика на вершину
+    unsigned char* used;        // Бит c - 1: у вершины есть сосед цвета c
+    int usage[5];               // Вершин каждого цвета
+    SaturationQueue queue;      // Нераскрашенные вершины по (насыщенности, степени)
+} SearchState;
+
+static inline int saturation(const SearchState* state, int v) {
+    return bit_count(state->used[v]);
+}
+
+static inline int degree(const SearchState* state, int v) {
+    return state->csr->offsets[v + 1] - state->csr->offsets[v];
+}
+
+// Красит v в цвет c. Возвращает 1, если у нераскрашенного соседа не осталось цветов.
+static int assign(SearchState* state, int v, int c) {
+    const Graph* csr = state->csr;
+    unsigned char bit = (unsigned char)(1u << (c - 1));
+    unsigned char all = (unsigned char)((1u << state->k) - 1);
+    int wipeout = 0;
+    saturation_queue_remove(&state->queue, v, saturation(state, v), degree(state, v));
+    state->colors[v] = c;
+    state->usage[c]++;
+    for (int e = csr->offsets[v]; e < csr->offsets[v + 1]; e++) {
+        int u = csr->neighbors[e];
+        if (state->neighbor_count[u * 4 + c - 1]++ == 0) {
+            if (!state->colors[u]) {
+                saturation_queue_remove(&state->queue, u, saturation(state, u), degree(state, u));
+                saturation_queue_insert(&state->queue, u, saturation(state, u) + 1, degree(state, u));
+            }
+            state->used[u] |= bit;
+            if (!state->colors[u] && state->used[u] == all) wipeout = 1;
+        }
+    }
+    return wipeout;
+}
+
+static void unassign(SearchState* state, int v) {
+    const Graph* csr = state->csr;
+    int c = state->colors[v];
+    unsigned char bit = (unsigned char)(1u << (c - 1));
+    state->colors[v] = 0;
+    state->usage[c]--;
+    for (int e = csr->offsets[v]; e < csr->offsets[v + 1]; e++) {
+        int u = csr->neighbors[e];
+        if (--state->neighbor_count[u * 4 + c - 1] == 0) {
+            if (!state->colors[u]) {
+                saturation_queue_remove(&state->queue, u, saturation(state, u), degree(state, u));
+                saturation_queue_insert(&state->queue, u, saturation(state, u) - 1, degree(state, u));
+            }
+            state->used[u] &= (unsigned char)~bit;
+        }
+    }
+    saturation_queue_insert(&state->queue, v, saturation(state, v), degree(state, v));
+}
+
+// Жадная клика: от каждой из первых EXACT_CLIQUE_SEEDS вершин добавляются
+// соседи, смежные со всеми уже взятыми. Поиск прекращается, как только
+// клика больше limit (этого достаточно для доказательства).
+static int greedy_clique(const Graph* csr, int limit, int* clique) {
+    int best = 0;
+    int current[8];
+    int seeds = csr->num_vertices - 1 < EXACT_CLIQUE_SEEDS ? csr->num_vertices - 1 : EXACT_CLIQUE_SEEDS;
+    for (int v = 1; v <= seeds && best <= limit; v++) {
+        int size = 0;
+        current[size++] = v;
+        for (int e = csr->offsets[v]; e < csr->offsets[v + 1] && size <= limit; e++) {
+            int u = csr->neighbors[e];
+            int adjacent = 1;
+            for (int i = 1; i < size && adjacent; i++) {
+                adjacent = graph_has_edge(csr, u, current[i]);
+            }
+            if (adjacent) current[size++] = u;
+        }
+        if (size > best) {
+            best = size;
+            for (int i = 0; i < size; i++) {
+                clique[i] = current[i];
+            }
+        }
+    }
+    return best;
+}
+
+ExactResult exact_k_coloring(const Graph* csr, int k, double time_budget, int* colors) {
+    int n = csr->num_vertices;
+    for (int v = 0; v < n; v++) {
+        colors[v] = 0;
+    }
+    if (n <= 1) return EXACT_COLORABLE;
+    int clique[8];
+    int clique_size = greedy_clique(csr, k, clique);
+    if (clique_size > k) return EXACT_NOT_COLORABLE;
+
+    SearchState state;
+    state.csr = csr;
+    state.k = k;
+    state.colors = colors;
+    state.neighbor_count = (int*)calloc((size_t)n * 4, sizeof(int));
+    state.used = (unsigned char*)calloc(n, 1);
+    int* stack = (int*)malloc(n * sizeof(int));
+    unsigned char* tried = (unsigned char*)malloc(n);
+    int max_degree = 0;
+    for (int v = 1; v < n; v++) {
+        if (degree(&state, v) > max_degree) max_degree = degree(&state, v);
+    }
+    int queue_ok = saturation_queue_init(&state.queue, n, max_degree);
+    if (!queue_ok || !state.neighbor_count || !state.used || !stack || !tried) {
+        saturation_queue_free(&state.queue);
+        free(state.neighbor_count);
+        free(state.used);
+        free(stack);
+        free(tried);
+        return EXACT_FAILED;
+    }
+    for (int c = 0; c <= 4; c++) {
+        state.usage[c] = 0;
+    }
+    // Вставка в обратном порядке: при равных ключах первым выходит меньший номер
+    for (int v = n - 1; v >= 1; v--) {
+        saturation_queue_insert(&state.queue, v, 0, degree(&state, v));
+    }
+
+    // Клика красится без перебора: в любой раскраске её цвета различны
+    ExactResult result = EXACT_COLORABLE;
+    int wipeout = 0;
+    for (int i = 0; i < clique_size; i++) {
+        wipeout |= assign(&state, clique[i], i + 1);
+    }
+    int remaining = n - 1 - clique_size;
+    if (wipeout) {
+        result = EXACT_NOT_COLORABLE;
+    } else if (remaining > 0) {
+        // Перебор без рекурсии: stack[depth] - вершина уровня, tried[depth] -
+        // уже испробованные на ней цвета
+        Timer timer;
+        start_timer(&timer);
+        long nodes = 0;
+        int depth = 0;
+        stack[0] = saturation_queue_peek_max(&state.queue);
+        tried[0] = 0;
+        for (;;) {
+            int v = stack[depth];
+            if (colors[v]) unassign(&state, v);
+            if (++nodes % EXACT_CHECK_NODES == 0) {
+                stop_timer(&timer);
+                if (get_duration(&timer) >= time_budget) {
+                    result = EXACT_TIMEOUT;
+                    break;
+                }
+            }
+            int max_used = 0;
+            for (int c = k; c >= 1 && !max_used; c--) {
+                if (state.usage[c]) max_used = c;
+            }
+            int limit = max_used + 1 < k ? max_used + 1 : k;
+            unsigned allowed = ((1u << limit) - 1) & ~state.used[v] & ~tried[depth];
+            if (!allowed) {
+                if (depth == 0) {
+                    result = EXACT_NOT_COLORABLE;
+                    break;
+                }
+                depth--;
+                continue;
+            }
+            int c = lowest_bit_index(allowed) + 1;
+            tried[depth] |= (unsigned char)(1u << (c - 1));
+            if (assign(&state, v, c)) continue;
+            if (depth + 1 == remaining) break;
+            depth++;
+            stack[depth] = saturation_queue_peek_max(&state.queue);
+            tried[depth] = 0;
+        }
+    }
+    saturation_queue_free(&state.queue);
+    free(state.neighbor_count);
+    free(state.used);
+    free(stack);
+    free(tried);
+    return result;
+}
+
+// Поиск k-раскраски компонент k-ядра, по задаче на компоненту
+typedef struct {
+    const Graph* core;
+    const GraphComponents* components;
+    int k;
+    Timer timer;        // Запущен в начале поиска: бюджет общий для всех компонент
+    double time_budget;
+    int* colors;        // В нумерации ядра
+    int* local_index;   // Общий для компонент, см. component_subgraph()
+    ExactResult* results;
+} ExactJob;
+
+static void exact_component_task(void* context, int c) {
+    ExactJob* job = (ExactJob*)context;
+    const int* vertices = job->components->vertices + job->components->start[c];
+    int count = job->components->start[c + 1] - job->components->start[c];
+    Graph* subgraph = component_subgraph(job->core, job->components, c, job->local_index);
+    int* colors = subgraph ? (int*)malloc((count + 1) * sizeof(int)) : NULL;
+    // Задачи разбираются по очереди, поэтому поздние получают остаток бюджета
+    Timer now = job->timer;
+    stop_timer(&now);
+    double remaining = job->time_budget - get_duration(&now);
+    ExactResult result = !colors ? EXACT_FAILED
+                       : remaining > 0 ? exact_k_coloring(subgraph, job->k, remaining, colors)
+                       : EXACT_TIMEOUT;
+    if (result == EXACT_COLORABLE) {
+        for (int i = 0; i < count; i++) {
+            job->colors[vertices[i]] = colors[i + 1];
+        }
+    }
+    job->results[c] = result;
+    free(colors);
+    free_graph(subgraph);
+}
+
+ExactResult exact_k_coloring_graph(const Graph* csr, int k, double time_budget, int num_threads, int* colors) {
+    PeeledGraph* peeled = peel_low_degree(csr, k);
+    GraphComponents* components = peeled ? find_components(peeled->core) : NULL;
+    ExactJob job;
+    job.core = peeled ? peeled->core : NULL;
+    job.components = components;
+    job.k = k;
+    start_timer(&job.timer);
+    job.time_budget = time_budget;
+    job.colors = peeled ? (int*)calloc(peeled->core->num_vertices, sizeof(int)) : NULL;
+    job.local_index = peeled ? (int*)malloc(peeled->core->num_vertices * sizeof(int)) : NULL;
+    job.results = components ? (ExactResult*)malloc((components->num_components + 1) * sizeof(ExactResult)) : NULL;
+    if (!components || !job.colors || !job.local_index || !job.results) {
+        free(job.colors);
+        free(job.local_index);
+        free(job.results);
+        free_graph_components(components);
+        free_peeled_graph(peeled);
+        return EXACT_FAILED;
+    }
+    parallel_for(components->num_components, num_threads, exact_component_task, &job);
+
+    int tally[4] = {0, 0, 0, 0};
+    for (int c = 0; c < components->num_components; c++) {
+        tally[job.results[c]]++;
+    }
+    log_message("k = %d: %d core vertices in %d components - colorable %d, not colorable %d, undecided %d\n",
+                k, peeled->core->num_vertices - 1, components->num_components,
+                tally[EXACT_COLORABLE], tally[EXACT_NOT_COLORABLE], tally[EXACT_TIMEOUT]);
+    ExactResult result;
+    if (tally[EXACT_FAILED] > 0) {
+        result = EXACT_FAILED;
+    } else if (tally[EXACT_COLORABLE] == components->num_components) {
+        // Снятые вершины при снятии имели меньше k соседей - k цветов им хватит
+        for (int i = 1; i < peeled->core->num_vertices; i++) {
+            colors[peeled->core_vertices[i]] = job.colors[i];
+        }
+        color_peeled_vertices(csr, peeled, k, colors);
+        result = EXACT_COLORABLE;
+    } else if (tally[EXACT_NOT_COLORABLE] > 0) {
+        result = EXACT_NOT_COLORABLE;
+    } else {
+        result = EXACT_TIMEOUT; // Ни одна компонента не опровергнута, но и не раскрашена
+    }
+    free(job.colors);
+    free(job.local_index);
+    free(job.results);
+    free_graph_components(components);
+    free_peeled_graph(peeled);
+    return result;
+}
+
+int exact_color_graph(const Graph* csr, int max_colors, double time_budget, int num_threads,
+                      int* colors, int* proven_optimal) {
+    int proven = 1; // Все меньшие k доказанно малы
+    *proven_optimal = 0;
+    // Один бюджет на все k: каждая попытка получает то, что осталось от предыдущих
+    Timer timer;
+    start_timer(&timer);
+    for (int k = 1; k <= max_colors; k++) {
+        stop_timer(&timer);
+        double remaining = time_budget - get_duration(&timer);
+        if (remaining <= 0) {
+            log_message("k = %d: time budget exhausted\n", k);
+            return 0;
+        }
+        ExactResult result = exact_k_coloring_graph(csr, k, remaining, num_threads, colors);
+        if (result == EXACT_FAILED) return -1;
+        if (result == EXACT_COLORABLE) {
+            *proven_optimal = proven;
+            return k;
+        }
+        if (result == EXACT_TIMEOUT) proven = 0;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef EXACT_COLORING_H
+#define EXACT_COLORING_H
+
+#include "graph.h"
+
+// Исход поиска k-раскраски
+typedef enum {
+    EXACT_COLORABLE = 0, // Раскраска найдена
+    EXACT_NOT_COLORABLE, // Доказано, что k цветов мало
+    EXACT_TIMEOUT,       // Бюджет времени исчерпан, ответа нет
+    EXACT_FAILED         // Нехватка памяти
+} ExactResult;
+
+// Точный поиск k-раскраски (k <= 4) связного графа csr перебором с
+// возвратом в порядке DSATUR (корзины saturation_queue.h, обновляются при
+// каждой раскраске и откате): следующей красится вершина с наименьшим
+// числом свободных цветов (домен - битовая маска), пустой домен соседа
+// сразу отсекает ветвь. Жадная клика даёт нижнюю границу и заранее
+// раскрашивается цветами 1 .. |клики|; новый цвет берётся не больше
+// наибольшего использованного плюс 1 (цвета равноправны).
+// time_budget - секунды реального времени. colors - num_vertices элементов.
+ExactResult exact_k_coloring(const Graph* csr, int k, double time_budget, int* colors);
+
+// k-раскраска всего графа csr: снимаются вершины степени меньше k (их
+// k цветов хватит всегда, см. peeling.h), компоненты k-ядра ищут
+// k-раскраску (exact_k_coloring) параллельно на num_threads потоках в пределах
+// общего бюджета time_budget: компонента, взятая в работу позже, получает
+// его остаток. EXACT_COLORABLE - colors заполнен целиком;
+// EXACT_NOT_COLORABLE - хотя бы одна компонента доказанно не раскрашивается;
+// EXACT_TIMEOUT - не опровергнута ни одна, но и раскрашены не все.
+// При других исходах colors не изменяется.
+ExactResult exact_k_coloring_graph(const Graph* csr, int k, double time_budget, int num_threads, int* colors);
+
+// Минимальная раскраска графа csr не больше чем в max_colors цветов.
+// Для k = 1, 2, ... вызывается exact_k_coloring_graph() с остатком общего
+// бюджета time_budget, поэтому весь поиск укладывается в time_budget секунд.
+// Первое k, при котором раскрашены все компоненты, - ответ; *proven_optimal
+// равно 1, если для всех меньших k хотя бы одна компонента доказанно
+// не раскрашивается. Возвращает число цветов, 0 - раскраска в max_colors
+// цветов не найдена (colors не изменяются), -1 - нехватка памяти.
+int exact_color_graph(const Graph* csr, int max_colors, double time_budget, int num_threads,
+                      int* colors, int* proven_optimal);
+
+#endif // EXACT_COLORING_H
\ No newline at end of file
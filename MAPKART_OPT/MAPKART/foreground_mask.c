@@ -0,0 +1,173 @@
+#include "foreground_mask.h"
+#include "parallel.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define FOREGROUND_MASK_X86 1
+#include <immintrin.h>
+#endif
+
+// Пиксель белый, если все каналы > 250 (как и раньше в is_white)
+#define WHITE_THRESHOLD 250
+
+static inline int is_white(Pixel p) {
+    return p.r > WHITE_THRESHOLD && p.g > WHITE_THRESHOLD && p.b > WHITE_THRESHOLD;
+}
+
+typedef struct {
+    const BMPImage* image;
+    ForegroundMask* mask;
+    int rows_per_task;
+} MaskBuild;
+
+// Таблица сжатия: 12 байтовых флагов (4 пикселя по 3 канала) -> 4 бита пикселей.
+// Заполняется один раз вместе с выбором SIMD-варианта.
+static uint8_t pack_table[4096];
+static int use_avx2 = 0;
+static pthread_once_t classify_init_once = PTHREAD_ONCE_INIT;
+
+static void init_classify(void) {
+    uint8_t* table = pack_table;
+    for (int flags = 0; flags < 4096; flags++) {
+        uint8_t packed = 0;
+        for (int k = 0; k < 4; k++) {
+            if (((flags >> (3 * k)) & 7) == 7) {
+                packed |= (uint8_t)(1 << k);
+            }
+        }
+        table[flags] = packed;
+    }
+#ifdef FOREGROUND_MASK_X86
+    use_avx2 = __builtin_cpu_supports("avx2");
+#endif
+}
+
+// 48 байтовых флагов (16 пикселей) -> 16 бит пикселей
+static inline uint64_t pack_16_pixels(const uint8_t* table, uint64_t flags) {
+    return (uint64_t)table[flags & 0xFFF]
+         | (uint64_t)table[(flags >> 12) & 0xFFF] << 4
+         | (uint64_t)table[(flags >> 24) & 0xFFF] << 8
+         | (uint64_t)table[(flags >> 36) & 0xFFF] << 12;
+}
+
+#ifdef FOREGROUND_MASK_X86
+// Флаг байта: v >= WHITE_THRESHOLD + 1 <=> max(v, порог) == v
+static inline uint64_t byte_flags_sse2(const uint8_t* p, __m128i threshold) {
+    __m128i v0 = _mm_loadu_si128((const __m128i*)p);
+    __m128i v1 = _mm_loadu_si128((const __m128i*)(p + 16));
+    __m128i v2 = _mm_loadu_si128((const __m128i*)(p + 32));
+    uint64_t m0 = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(v0, threshold), v0));
+    uint64_t m1 = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(v1, threshold), v1));
+    uint64_t m2 = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(v2, threshold), v2));
+    return m0 | m1 << 16 | m2 << 32;
+}
+
+// SSE2: 16 пикселей (48 байт) за итерацию. Возвращает число обработанных пикселей.
+static int classify_row_sse2(const uint8_t* bytes, int width, uint64_t* words, const uint8_t* table) {
+    __m128i threshold = _mm_set1_epi8((char)(WHITE_THRESHOLD + 1));
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        uint64_t packed = pack_16_pixels(table, byte_flags_sse2(bytes + 3 * x, threshold));
+        words[x >> 6] |= packed << (x & 63);
+    }
+    return x;
+}
+
+__attribute__((target("avx2")))
+static int classify_row_avx2(const uint8_t* bytes, int width, uint64_t* words, const uint8_t* table) {
+    __m256i threshold = _mm256_set1_epi8((char)(WHITE_THRESHOLD + 1));
+    int x = 0;
+    // AVX2: 32 пикселя (96 байт) за итерацию
+    for (; x + 32 <= width; x += 32) {
+        const uint8_t* p = bytes + 3 * x;
+        __m256i v0 = _mm256_loadu_si256((const __m256i*)p);
+        __m256i v1 = _mm256_loadu_si256((const __m256i*)(p + 32));
+        __m256i v2 = _mm256_loadu_si256((const __m256i*)(p + 64));
+        uint64_t m0 = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(v0, threshold), v0));
+        uint64_t m1 = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(v1, threshold), v1));
+        uint64_t m2 = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(v2, threshold), v2));
+        uint64_t low = m0 | (m1 & 0xFFFF) << 32;  // Пиксели x .. x + 15
+        uint64_t high = (m1 >> 16) | m2 << 16;    // Пиксели x + 16 .. x + 31
+        uint64_t packed = pack_16_pixels(table, low) | pack_16_pixels(table, high) << 16;
+        words[x >> 6] |= packed << (x & 63);
+    }
+    // Хвост короче 32 пикселей добираем через SSE2
+    __m128i threshold128 = _mm_set1_epi8((char)(WHITE_THRESHOLD + 1));
+    for (; x + 16 <= width; x += 16) {
+        uint64_t packed = pack_16_pixels(table, byte_flags_sse2(bytes + 3 * x, threshold128));
+        words[x >> 6] |= packed << (x & 63);
+    }
+    return x;
+}
+#endif
+
+void classify_row(const Pixel* row, int width, uint64_t* words) {
+    pthread_once(&classify_init_once, init_classify);
+    memset(words, 0, ((width + 63) / 64) * sizeof(uint64_t));
+
+    int x = 0;
+#ifdef FOREGROUND_MASK_X86
+    if (use_avx2) {
+        x = classify_row_avx2((const uint8_t*)row, width, words, pack_table);
+    } else {
+        x = classify_row_sse2((const uint8_t*)row, width, words, pack_table);
+    }
+#endif
+    // Скалярный вариант: хвост строки или платформа без SIMD
+    for (; x < width; x++) {
+        if (is_white(row[x])) {
+            words[x >> 6] |= (uint64_t)1 << (x & 63);
+        }
+    }
+}
+
+static void classify_rows_task(void* context, int task_index) {
+    MaskBuild* ctx = (MaskBuild*)context;
+    ForegroundMask* mask = ctx->mask;
+    int width = mask->width;
+    int y_begin = task_index * ctx->rows_per_task;
+    int y_end = y_begin + ctx->rows_per_task;
+    if (y_end > mask->height) y_end = mask->height;
+
+    for (int y = y_begin; y < y_end; y++) {
+        classify_row(ctx->image->data + (long)y * width, width,
+                     mask->bits + (long)y * mask->words_per_row);
+    }
+}
+
+ForegroundMask* build_foreground_mask(const BMPImage* image, int num_threads) {
+    ForegroundMask* mask = (ForegroundMask*)malloc(sizeof(ForegroundMask));
+    if (!mask) {
+        fprintf(stderr, "Failed to allocate memory for foreground mask.\n");
+        return NULL;
+    }
+
+    mask->width = image->info_header.width;
+    mask->height = image->info_header.height;
+    mask->words_per_row = (mask->width + 63) / 64;
+    mask->bits = (uint64_t*)malloc((size_t)mask->words_per_row * mask->height * sizeof(uint64_t));
+    if (!mask->bits) {
+        fprintf(stderr, "Failed to allocate memory for foreground mask.\n");
+        free(mask);
+        return NULL;
+    }
+
+    MaskBuild ctx;
+    ctx.image = image;
+    ctx.mask = mask;
+    ctx.rows_per_task = 64;
+
+    int num_tasks = (mask->height + ctx.rows_per_task - 1) / ctx.rows_per_task;
+    parallel_for(num_tasks, num_threads, classify_rows_task, &ctx);
+    return mask;
+}
+
+void free_foreground_mask(ForegroundMask* mask) {
+    if (mask) {
+        free(mask->bits);
+        free(mask);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#ifndef FOREGROUND_MASK_H
+#define FOREGROUND_MASK_H
+
+#include <stdint.h>
+#include "bmp_handler.h"
+
+// Битовая маска белых пикселей: 1 бит на пиксель вместо 3 байт.
+// Каждая строка занимает words_per_row 64-битных слов, бит x % 64 слова x / 64
+// соответствует пикселю x. Лишние биты в конце строки всегда равны 0.
+typedef struct {
+    uint64_t* bits;
+    int width;
+    int height;
+    int words_per_row;
+} ForegroundMask;
+
+// Классифицирует все пиксели изображения за один проход (SSE2/AVX2, если доступны)
+ForegroundMask* build_foreground_mask(const BMPImage* image, int num_threads);
+// Классифицирует одну строку из width пикселей в (width + 63) / 64 слов маски
+void classify_row(const Pixel* row, int width, uint64_t* words);
+void free_foreground_mask(ForegroundMask* mask);
+
+static inline const uint64_t* mask_row(const ForegroundMask* mask, int y) {
+    return mask->bits + (long)y * mask->words_per_row;
+}
+
+// Номер младшего установленного бита (word != 0)
+static inline int lowest_bit_index(uint64_t word) {
+    return __builtin_ctzll(word);
+}
+
+// Число установленных битов
+static inline int bit_count(uint64_t word) {
+    return __builtin_popcountll(word);
+}
+
+// Маска битов строки ширины width, соответствующих реальным пикселям слова word_index
+static inline uint64_t row_valid_bits(int width, int word_index) {
+    int tail = width - (word_index << 6);
+    return tail >= 64 ? ~(uint64_t)0 : (((uint64_t)1 << tail) - 1);
+}
+
+// Первый белый пиксель строки, начиная с x (width, если его нет)
+static inline int row_next_set(const uint64_t* words, int x, int width) {
+    if (x >= width) return width;
+    int w = x >> 6;
+    uint64_t word = words[w] & (~(uint64_t)0 << (x & 63));
+    int words_per_row = (width + 63) >> 6;
+    while (!word) {
+        if (++w >= words_per_row) return width;
+        word = words[w];
+    }
+    return (w << 6) + lowest_bit_index(word);
+}
+
+// Первый пиксель границы строки, начиная с x (width, если его нет)
+static inline int row_next_clear(const uint64_t* words, int x, int width) {
+    if (x >= width) return width;
+    int w = x >> 6;
+    uint64_t word = ~words[w] & (~(uint64_t)0 << (x & 63));
+    int words_per_row = (width + 63) >> 6;
+    while (!word) {
+        if (++w >= words_per_row) return width;
+        word = ~words[w];
+    }
+    int result = (w << 6) + lowest_bit_index(word);
+    return result < width ? result : width;
+}
+
+static inline int mask_test(const ForegroundMask* mask, int x, int y) {
+    return (int)((mask_row(mask, y)[x >> 6] >> (x & 63)) & 1);
+}
+
+#endif // FOREGROUND_MASK_H
\ No newline at end of file
@@ -1,8 +1,14 @@
 #include "graph.h"
 #include <stdio.h>
+#include <string.h>
 #include "colorizer.h"
+#include "edge_buffer.h"
+#include "parallel.h"
+#include "row_transitions.h"
+#include "border_growth.h"
 Graph* create_graph(int num_vertices) {
-    Graph* graph = (Graph*)malloc(sizeof(Graph));
+    Graph* graph = (Graph*)calloc(1, sizeof(Graph));
+    graph->kind = GRAPH_DENSE;
     graph->num_vertices = num_vertices;
     graph->matrix = (int**)calloc(num_vertices, sizeof(int*));
     for (int i = 0; i < num_vertices; i++) {
@@ -10,12 +16,78 @@ Graph* create_graph(int num_vertices) {
     }
     return graph;
 }
+// CSR: степени -> смещения (префиксные суммы) -> раскладка соседей.
+// Рёбра отсортированы по (u, v), поэтому списки соседей получаются упорядоченными.
+static Graph* create_csr_graph(int num_vertices, const Edge* edges, int num_edges) {
+    Graph* graph = (Graph*)calloc(1, sizeof(Graph));
+    if (!graph) return NULL;
+    graph->kind = GRAPH_CSR;
+    graph->num_vertices = num_vertices;
+    graph->num_edges = num_edges;
+    graph->offsets = (int*)calloc(num_vertices + 1, sizeof(int));
+    graph->neighbors = (int*)malloc((2 * (size_t)num_edges + 1) * sizeof(int));
+    int* fill = (int*)malloc((num_vertices + 1) * sizeof(int));
+    if (!graph->offsets || !graph->neighbors || !fill) {
+        free(fill);
+        free_graph(graph);
+        return NULL;
+    }
+    for (int i = 0; i < num_edges; i++) {
+        graph->offsets[edges[i].u + 1]++;
+        graph->offsets[edges[i].v + 1]++;
+    }
+    for (int v = 0; v < num_vertices; v++) {
+        graph->offsets[v + 1] += graph->offsets[v];
+    }
+    memcpy(fill, graph->offsets, (num_vertices + 1) * sizeof(int));
+    // Сначала соседи v, меньшие v (рёбра (u, v) с u < v идут по возрастанию u),
+    // затем большие - так каждый список упорядочен без дополнительной сортировки
+    for (int i = 0; i < num_edges; i++) {
+        graph->neighbors[fill[edges[i].v]++] = edges[i].u;
+    }
+    for (int i = 0; i < num_edges; i++) {
+        graph->neighbors[fill[edges[i].u]++] = edges[i].v;
+    }
+    free(fill);
+    return graph;
+}
+// Битовая матрица: V² / 8 байт вместо V² * 4, строки выровнены по 64 битам
+static Graph* create_bitset_graph(int num_vertices) {
+    Graph* graph = (Graph*)calloc(1, sizeof(Graph));
+    if (!graph) return NULL;
+    graph->kind = GRAPH_BITSET;
+    graph->num_vertices = num_vertices;
+    graph->words_per_row = (num_vertices + 63) / 64;
+    graph->bits = (uint64_t*)calloc((size_t)num_vertices * graph->words_per_row + 1, sizeof(uint64_t));
+    if (!graph->bits) {
+        free(graph);
+        return NULL;
+    }
+    return graph;
+}
+Graph* create_graph_from_edges(int num_vertices, const Edge* edges, int num_edges, GraphKind kind) {
+    if (kind == GRAPH_CSR) {
+        return create_csr_graph(num_vertices, edges, num_edges);
+    }
+    Graph* graph = kind == GRAPH_BITSET ? create_bitset_graph(num_vertices) : create_graph(num_vertices);
+    if (!graph) return NULL;
+    for (int i = 0; i < num_edges; i++) {
+        add_edge(graph, edges[i].u, edges[i].v);
+    }
+    graph->num_edges = num_edges;
+    return graph;
+}
 void free_graph(Graph* graph) {
     if (graph) {
-        for (int i = 0; i < graph->num_vertices; i++) {
-            free(graph->matrix[i]);
+        if (graph->matrix) {
+            for (int i = 0; i < graph->num_vertices; i++) {
+                free(graph->matrix[i]);
+            }
+            free(graph->matrix);
         }
-        free(graph->matrix);
+        free(graph->offsets);
+        free(graph->neighbors);
+        free(graph->bits);
         free(graph);
     }
 }
@@ -24,142 +96,230 @@ static inline void add_edge_fast(Graph* graph, int v1, int v2) {
     graph->matrix[v2][v1] = 1;
 }
 void add_edge(Graph* graph, int v1, int v2) {
-    if (v1 != v2) {
+    if (v1 == v2) return;
+    if (graph->kind == GRAPH_BITSET) {
+        graph_bit_row(graph, v1)[v2 >> 6] |= (uint64_t)1 << (v2 & 63);
+        graph_bit_row(graph, v2)[v1 >> 6] |= (uint64_t)1 << (v1 & 63);
+    } else {
         add_edge_fast(graph, v1, v2);
     }
 }
-Graph* build_adjacency_graph(int* region_map, int width, int height, int num_regions) {
-    log_message("\nSTEP 0: Building adjacency graph\n");
-    log_message("=================================\n");
-    log_message("Image dimensions: %d x %d\n", width, height);
-    log_message("Number of regions: %d\n", num_regions);
-    Graph* graph = create_graph(num_regions + 1);
-    int edge_count = 0;
-    int* region_pixel_count = (int*)calloc(num_regions + 1, sizeof(int));
-    int* region_border_pixel_count = (int*)calloc(num_regions + 1, sizeof(int));
-    const int width_const = width; 
-    for (int y = 0; y < height; y++) {
-        int y_offset = y * width_const; 
-        for (int x = 0; x < width; x++) {
-            int current_idx = y_offset + x;
-            int current_region = region_map[current_idx];
-            if (current_region > 0) {
-                region_pixel_count[current_region]++;
-                if (y > 0) {
-                    int neighbor_idx = (y - 1) * width_const + x;
-                    int neighbor_region = region_map[neighbor_idx];
-                    if (neighbor_region > 0 && neighbor_region != current_region) {
-                        int* row = graph->matrix[current_region];
-                        if (!row[neighbor_region]) {
-                            add_edge_fast(graph, current_region, neighbor_region);
-                            edge_count++;
-                            log_message("Added edge: Region %d <-> Region %d (direct contact at %d,%d)\n", 
-                                      current_region, neighbor_region, x, y);
-                        }
-                    } else if (neighbor_region == 0) {
-                        region_border_pixel_count[current_region]++;
-                    }
-                }
-                if (y < height - 1) {
-                    int neighbor_idx = (y + 1) * width_const + x;
-                    int neighbor_region = region_map[neighbor_idx];
-                    if (neighbor_region > 0 && neighbor_region != current_region) {
-                        int* row = graph->matrix[current_region];
-                        if (!row[neighbor_region]) {
-                            add_edge_fast(graph, current_region, neighbor_region);
-                            edge_count++;
-                            log_message("Added edge: Region %d <-> Region %d (direct contact at %d,%d)\n", 
-                                      current_region, neighbor_region, x, y);
-                        }
-                    }
+int graph_has_edge(const Graph* graph, int v1, int v2) {
+    if (graph->kind == GRAPH_BITSET) {
+        return (graph_bit_row(graph, v1)[v2 >> 6] >> (v2 & 63)) & 1;
+    }
+    if (graph->kind == GRAPH_CSR) {
+        // Списки соседей упорядочены - двоичный поиск
+        int lo = graph->offsets[v1];
+        int hi = graph->offsets[v1 + 1];
+        while (lo < hi) {
+            int mid = (lo + hi) >> 1;
+            if (graph->neighbors[mid] < v2) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo < graph->offsets[v1 + 1] && graph->neighbors[lo] == v2;
+    }
+    return graph->matrix[v1][v2];
+}
+// Рёбра u < v по возрастанию (u, v); если edges == NULL, только считает их
+static int list_edges(const Graph* graph, Edge* edges) {
+    int count = 0;
+    for (int u = 0; u < graph->num_vertices; u++) {
+        if (graph->kind == GRAPH_CSR) {
+            for (int k = graph->offsets[u]; k < graph->offsets[u + 1]; k++) {
+                if (graph->neighbors[k] <= u) continue;
+                if (edges) {
+                    edges[count].u = u;
+                    edges[count].v = graph->neighbors[k];
                 }
-                if (x > 0) {
-                    int neighbor_idx = y_offset + (x - 1);
-                    int neighbor_region = region_map[neighbor_idx];
-                    if (neighbor_region > 0 && neighbor_region != current_region) {
-                        int* row = graph->matrix[current_region];
-                        if (!row[neighbor_region]) {
-                            add_edge_fast(graph, current_region, neighbor_region);
-                            edge_count++;
-                            log_message("Added edge: Region %d <-> Region %d (direct contact at %d,%d)\n", 
-                                      current_region, neighbor_region, x, y);
-                        }
+                count++;
+            }
+        } else if (graph->kind == GRAPH_BITSET) {
+            const uint64_t* row = graph_bit_row(graph, u);
+            int first_word = (u + 1) >> 6;
+            for (int w = first_word; w < graph->words_per_row; w++) {
+                uint64_t word = row[w];
+                if (w == first_word) word &= ~(uint64_t)0 << ((u + 1) & 63);
+                while (word) {
+                    if (edges) {
+                        edges[count].u = u;
+                        edges[count].v = (w << 6) + lowest_bit_index(word);
                     }
+                    count++;
+                    word &= word - 1;
                 }
-                if (x < width - 1) {
-                    int neighbor_idx = y_offset + (x + 1);
-                    int neighbor_region = region_map[neighbor_idx];
-                    if (neighbor_region > 0 && neighbor_region != current_region) {
-                        int* row = graph->matrix[current_region];
-                        if (!row[neighbor_region]) {
-                            add_edge_fast(graph, current_region, neighbor_region);
-                            edge_count++;
-                            log_message("Added edge: Region %d <-> Region %d (direct contact at %d,%d)\n", 
-                                      current_region, neighbor_region, x, y);
-                        }
-                    }
+            }
+        } else {
+            for (int v = u + 1; v < graph->num_vertices; v++) {
+                if (!graph->matrix[u][v]) continue;
+                if (edges) {
+                    edges[count].u = u;
+                    edges[count].v = v;
                 }
+                count++;
             }
         }
     }
-    log_message("\nSearching for regions adjacent through borders...\n");
-    for (int y = 1; y < height - 1; y++) {
-        int y_offset = y * width_const;
-        for (int x = 1; x < width - 1; x++) {
-            int current_idx = y_offset + x;
-            int current_region = region_map[current_idx];
-            if (current_region == 0) {
-                unsigned int region_mask = 0;
-                int found_regions[4];
-                int region_count = 0;
-                int up_region = region_map[(y - 1) * width_const + x];
-                if (up_region > 0 && !(region_mask & (1u << up_region))) {
-                    region_mask |= (1u << up_region);
-                    found_regions[region_count++] = up_region;
-                }
-                int down_region = region_map[(y + 1) * width_const + x];
-                if (down_region > 0 && !(region_mask & (1u << down_region))) {
-                    region_mask |= (1u << down_region);
-                    found_regions[region_count++] = down_region;
-                }
-                int left_region = region_map[y_offset + (x - 1)];
-                if (left_region > 0 && !(region_mask & (1u << left_region))) {
-                    region_mask |= (1u << left_region);
-                    found_regions[region_count++] = left_region;
-                }
-                int right_region = region_map[y_offset + (x + 1)];
-                if (right_region > 0 && !(region_mask & (1u << right_region))) {
-                    region_mask |= (1u << right_region);
-                    found_regions[region_count++] = right_region;
-                }
-                if (region_count > 1) {
-                    for (int i = 0; i < region_count; i++) {
-                        int r1 = found_regions[i];
-                        int* row1 = graph->matrix[r1];
-                        for (int j = i + 1; j < region_count; j++) {
-                            int r2 = found_regions[j];
-                            if (!row1[r2]) {
-                                add_edge_fast(graph, r1, r2);
-                                edge_count++;
-                                log_message("Added edge: Region %d <-> Region %d (through border at %d,%d)\n", 
-                                          r1, r2, x, y);
-                            }
-                        }
-                    }
-                }
+    return count;
+}
+Edge* graph_edge_list(const Graph* graph, int* num_edges) {
+    // CSR хранит число рёбер точно; матрицы могли дополняться через add_edge()
+    int count = graph->kind == GRAPH_CSR ? graph->num_edges : list_edges(graph, NULL);
+    Edge* edges = (Edge*)malloc(((size_t)count + 1) * sizeof(Edge));
+    if (!edges) return NULL;
+    *num_edges = list_edges(graph, edges);
+    return edges;
+}
+const Graph* graph_csr_view(const Graph* graph, Graph** owned) {
+    *owned = NULL;
+    if (graph->kind == GRAPH_CSR) return graph;
+    int num_edges = 0;
+    Edge* edges = graph_edge_list(graph, &num_edges);
+    if (!edges) return NULL;
+    *owned = create_graph_from_edges(graph->num_vertices, edges, num_edges, GRAPH_CSR);
+    free(edges);
+    return *owned;
+}
+// Состояние построения графа, общее для всех строк.
+// Найденные касания копятся в буфере рёбер; повторы убираются в finish_builder().
+typedef struct {
+    int width;
+    int height;
+    int num_regions;
+    GraphKind kind;
+    EdgeBuffer edges;
+    int failed; // Не удалось прочитать строку
+} AdjacencyBuilder;
+static inline void push_edge(AdjacencyBuilder* builder, int a, int b) {
+    edge_buffer_push(&builder->edges, a, b);
+}
+// Регионы вокруг пикселя границы x (не на краю изображения), разделённые им
+static inline void scan_border_pixel(AdjacencyBuilder* builder, const int* up, const int* cur, const int* down,
+                                     int x) {
+    // Соседей не больше четырёх: повторы отсекаются прямым сравнением
+    // с уже найденными (маска 1u << region работала только для номеров < 32)
+    int candidates[4] = {up[x], down[x], cur[x - 1], cur[x + 1]};
+    int found_regions[4];
+    int region_count = 0;
+    for (int k = 0; k < 4; k++) {
+        int region = candidates[k];
+        if (region <= 0) continue;
+        int seen = 0;
+        for (int i = 0; i < region_count; i++) {
+            seen |= found_regions[i] == region;
+        }
+        if (!seen) {
+            found_regions[region_count++] = region;
+        }
+    }
+    if (region_count > 1) {
+        for (int i = 0; i < region_count; i++) {
+            for (int j = i + 1; j < region_count; j++) {
+                push_edge(builder, found_regions[i], found_regions[j]);
             }
         }
     }
+}
+// Переходы меток строки y плотной карты (см. row_transitions.h)
+typedef struct {
+    uint64_t* horizontal; // cur[x] != cur[x + 1]
+    uint64_t* vertical;   // cur[x] != down[x]
+    uint64_t* above;      // up[x] != cur[x] (vertical предыдущей строки)
+} RowTransitions;
+// Все касания строки y по маскам переходов меток:
+// прямые - белые пиксели, у которых отличается метка справа или снизу
+// (касания слева и сверху уже найдены с другой стороны пары),
+// через границу - пиксели границы внутри изображения, у которых хотя бы
+// один сосед отличается от них, т.е. не равен 0. Остальные пиксели строки
+// (внутренность регионов и толстых границ) вообще не просматриваются.
+static void scan_row(AdjacencyBuilder* builder, const int* up, const int* cur, const int* down,
+                     const uint64_t* fg_words, const RowTransitions* transitions) {
+    const int width = builder->width;
+    const int words_per_row = (width + 63) >> 6;
+    const int interior = up && down; // Через границу - только для 1 <= y < height - 1
+    uint64_t carry = 0; // Бит 63 horizontal предыдущего слова: переход слева от x = 64 * w
+    for (int w = 0; w < words_per_row; w++) {
+        uint64_t fg = fg_words[w];
+        uint64_t horizontal = transitions->horizontal[w];
+        uint64_t vertical = transitions->vertical[w];
+        uint64_t word = fg & horizontal;
+        while (word) {
+            int x = (w << 6) + lowest_bit_index(word);
+            word &= word - 1;
+            if (cur[x + 1] > 0) push_edge(builder, cur[x], cur[x + 1]);
+        }
+        word = fg & vertical;
+        while (word) {
+            int x = (w << 6) + lowest_bit_index(word);
+            word &= word - 1;
+            if (down[x] > 0) push_edge(builder, cur[x], down[x]);
+        }
+        uint64_t left = horizontal << 1 | carry;
+        carry = horizontal >> 63;
+        if (!interior) continue;
+        // Пиксели границы, кроме крайних столбцов, рядом с которыми меняется метка
+        word = ~fg & row_valid_bits(width, w) & (horizontal | left | vertical | transitions->above[w]);
+        if (w == 0) word &= ~(uint64_t)1;
+        if (w == (width - 1) >> 6) word &= ~((uint64_t)1 << ((width - 1) & 63));
+        while (word) {
+            int x = (w << 6) + lowest_bit_index(word);
+            word &= word - 1;
+            scan_border_pixel(builder, up, cur, down, x);
+        }
+    }
+}
+static void init_builder(AdjacencyBuilder* builder, int width, int height, int num_regions, GraphKind kind) {
+    log_message("\nSTEP 0: Building adjacency graph\n");
+    log_message("=================================\n");
+    log_message("Image dimensions: %d x %d\n", width, height);
+    log_message("Number of regions: %d\n", num_regions);
+    log_message("Graph representation: %s\n",
+                kind == GRAPH_CSR ? "CSR" : kind == GRAPH_BITSET ? "bit matrix" : "dense matrix");
+    builder->width = width;
+    builder->height = height;
+    builder->num_regions = num_regions;
+    builder->kind = kind;
+    init_edge_buffer(&builder->edges);
+    builder->failed = 0;
+}
+// Сортирует найденные касания, убирает повторы и строит граф
+static Graph* finish_builder(AdjacencyBuilder* builder) {
+    EdgeBuffer* buffer = &builder->edges;
+    int candidate_count = buffer->count;
+    int edge_count = builder->failed || buffer->failed ? -1 : sort_unique_edge_keys(buffer->keys, candidate_count);
+    Edge* edges = edge_count >= 0 ? (Edge*)malloc((edge_count + 1) * sizeof(Edge)) : NULL;
+    if (!edges) {
+        fprintf(stderr, "Failed to build adjacency graph.\n");
+        free_edge_buffer(buffer);
+        return NULL;
+    }
+    for (int i = 0; i < edge_count; i++) {
+        edges[i].u = edge_key_u(buffer->keys[i]);
+        edges[i].v = edge_key_v(buffer->keys[i]);
+        log_message("Added edge: Region %d <-> Region %d\n", edges[i].u, edges[i].v);
+    }
+    free_edge_buffer(buffer);
+    Graph* graph = create_graph_from_edges(builder->num_regions + 1, edges, edge_count, builder->kind);
+    free(edges);
+    if (!graph) {
+        fprintf(stderr, "Failed to allocate memory for adjacency graph.\n");
+        return NULL;
+    }
     log_message("\nGraph construction complete:\n");
+    log_message("  Candidate contacts: %d\n", candidate_count);
     log_message("  Total edges added: %d\n", edge_count);
     log_message("  Graph vertices: %d\n", graph->num_vertices);
-    log_message("\nRegion statistics:\n");
-    for (int i = 1; i <= num_regions; i++) {
-        log_message("  Region %d: %d pixels, %d border pixels\n", 
-                   i, region_pixel_count[i], region_border_pixel_count[i]);
+    if (graph->kind == GRAPH_CSR) {
+        log_message("\nAdjacency lists:\n");
+        for (int i = 1; i < graph->num_vertices; i++) {
+            log_message("%2d:", i);
+            for (int k = graph->offsets[i]; k < graph->offsets[i + 1]; k++) {
+                log_message(" %d", graph->neighbors[k]);
+            }
+            log_message("\n");
+        }
+        return graph;
     }
-    free(region_pixel_count);
-    free(region_border_pixel_count);
     log_message("\nAdjacency matrix:\n");
     log_message("     ");
     for (int i = 1; i < graph->num_vertices; i++) {
@@ -169,9 +329,375 @@ Graph* build_adjacency_graph(int* region_map, int width, int height, int num_reg
     for (int i = 1; i < graph->num_vertices; i++) {
         log_message("%2d: ", i);
         for (int j = 1; j < graph->num_vertices; j++) {
-            log_message("%2d ", graph->matrix[i][j]);
+            log_message("%2d ", graph_has_edge(graph, i, j));
         }
         log_message("\n");
     }
     return graph;
+}
+// Строки [y_begin, y_end) плотной карты регионов.
+// Маски переходов считаются по ходу: vertical строки y становится above строки y + 1.
+static void scan_map_rows(AdjacencyBuilder* builder, const int* region_map, const ForegroundMask* mask,
+                          int y_begin, int y_end) {
+    const int width_const = builder->width;
+    const int height = builder->height;
+    const int words_per_row = mask->words_per_row;
+    uint64_t* words = (uint64_t*)malloc(3 * (size_t)words_per_row * sizeof(uint64_t));
+    if (!words) {
+        builder->failed = 1;
+        return;
+    }
+    RowTransitions transitions = {words, words + words_per_row, words + 2 * words_per_row};
+    if (y_begin > 0) {
+        // Первая строка полосы: переходы между строками y_begin - 1 и y_begin
+        // (horizontal здесь лишь черновик - он пересчитывается в цикле)
+        const int* row = region_map + (size_t)(y_begin - 1) * width_const;
+        find_row_transitions(row, row + width_const, width_const, transitions.horizontal, transitions.above);
+    } else {
+        memset(transitions.above, 0, (size_t)words_per_row * sizeof(uint64_t));
+    }
+    for (int y = y_begin; y < y_end; y++) {
+        const int* row = region_map + (size_t)y * width_const; // Индуктивная переменная
+        const int* down = y < height - 1 ? row + width_const : NULL;
+        find_row_transitions(row, down, width_const, transitions.horizontal, transitions.vertical);
+        scan_row(builder, y > 0 ? row - width_const : NULL, row, down, mask_row(mask, y), &transitions);
+        uint64_t* swap = transitions.above;
+        transitions.above = transitions.vertical;
+        transitions.vertical = swap;
+    }
+    free(words);
+}
+// Строки [y_begin, y_end) по индексу пикселей границы: просматриваются только
+// пиксели, у которых не меньше двух белых соседей. При 4-связной разметке
+// соседние белые пиксели всегда в одном регионе, поэтому прямых касаний нет
+// и все рёбра дают пиксели границы из индекса.
+static void scan_index_rows(AdjacencyBuilder* builder, const int* region_map, const BorderIndex* index,
+                            int y_begin, int y_end) {
+    const int width_const = builder->width;
+    for (int y = y_begin; y < y_end; y++) {
+        int count;
+        const BorderRun* runs = border_row_runs(index, y, &count);
+        if (count == 0) continue;
+        const int* row = region_map + (size_t)y * width_const; // Индуктивная переменная
+        for (int i = 0; i < count; i++) {
+            int x_end = runs[i].start + runs[i].length;
+            for (int x = runs[i].start; x < x_end; x++) {
+                scan_border_pixel(builder, row - width_const, row, row + width_const, x);
+            }
+        }
+    }
+}
+// Строки [y_begin, y_end) проросшей карты (толстые границы, см. border_growth.h).
+// Регионы a и b соседние, если между ними не больше max_distance пикселей границы:
+// - соседние пиксели p (a) и q (b) с distance[p] + distance[q] <= max_distance;
+// - пиксель границы на расстоянии d, до которого на одном шаге дошли несколько
+//   регионов, при 2d - 1 <= max_distance - все пары этих регионов (точка «ничьей»
+//   принадлежит только одному из них, так что первое правило пары не увидит).
+// При max_distance == 1 это в точности правило касаний через один пиксель границы.
+static void scan_grown_rows(AdjacencyBuilder* builder, const BorderGrowth* growth, int y_begin, int y_end) {
+    const int width = builder->width;
+    const int height = builder->height;
+    const int max_distance = growth->max_distance;
+    const int* labels = growth->labels;
+    const uint16_t* distance = growth->distance;
+    for (int y = y_begin; y < y_end; y++) {
+        size_t row = (size_t)y * width;
+        for (int x = 0; x < width; x++) {
+            size_t index = row + x;
+            int label = labels[index];
+            if (label == 0) continue;
+            int d = distance[index];
+            if (x < width - 1) {
+                int neighbor = labels[index + 1];
+                if (neighbor > 0 && neighbor != label && d + distance[index + 1] <= max_distance) {
+                    push_edge(builder, label, neighbor);
+                }
+            }
+            if (y < height - 1) {
+                int neighbor = labels[index + width];
+                if (neighbor > 0 && neighbor != label && d + distance[index + width] <= max_distance) {
+                    push_edge(builder, label, neighbor);
+                }
+            }
+            if (d == 0 || 2 * d - 1 > max_distance) continue;
+            // Проросшие пиксели не бывают на краю изображения, все четыре соседа есть
+            size_t neighbors[4] = {index - width, index + width, index - 1, index + 1};
+            int found_regions[4];
+            int region_count = 0;
+            for (int k = 0; k < 4; k++) {
+                if (distance[neighbors[k]] != d - 1) continue;
+                int region = labels[neighbors[k]];
+                int seen = 0;
+                for (int i = 0; i < region_count; i++) {
+                    seen |= found_regions[i] == region;
+                }
+                if (!seen) {
+                    found_regions[region_count++] = region;
+                }
+            }
+            for (int i = 0; i < region_count; i++) {
+                for (int j = i + 1; j < region_count; j++) {
+                    push_edge(builder, found_regions[i], found_regions[j]);
+                }
+            }
+        }
+    }
+}
+// Касание регионов a и b (для построения по отрезкам: метки могут совпадать)
+static inline void push_run_edge(AdjacencyBuilder* builder, int a, int b) {
+    if (a != b) push_edge(builder, a, b);
+}
+// Номер региона в столбце x строки runs[0 .. count - 1] (0 - граница).
+// *cursor - индекс первого отрезка, который может содержать x; запросы
+// в одной строке идут слева направо, поэтому курсор только растёт.
+static inline int label_at(const LabelRun* runs, int count, int* cursor, int x) {
+    while (*cursor < count && runs[*cursor].start + runs[*cursor].length <= x) {
+        (*cursor)++;
+    }
+    return *cursor < count && runs[*cursor].start <= x ? runs[*cursor].label : 0;
+}
+// Пары (отрезок a, отрезок b) с разными метками, пересекающиеся внутри [lo, hi)
+static void push_overlaps(AdjacencyBuilder* builder, const LabelRun* a, int a_count, int i,
+                          const LabelRun* b, int b_count, int j, int lo, int hi) {
+    while (i < a_count && j < b_count && a[i].start < hi && b[j].start < hi) {
+        int a_end = a[i].start + a[i].length;
+        int b_end = b[j].start + b[j].length;
+        int from = a[i].start > b[j].start ? a[i].start : b[j].start;
+        int to = a_end < b_end ? a_end : b_end;
+        if (from < lo) from = lo;
+        if (to > hi) to = hi;
+        if (from < to) {
+            push_run_edge(builder, a[i].label, b[j].label);
+        }
+        if (a_end < b_end) i++;
+        else j++;
+    }
+}
+// Все касания строки y по отрезкам строк y - 1 (up), y (cur) и y + 1 (down)
+// - то же, что scan_row(), но за O(число отрезков) вместо O(ширины):
+// - прямые касания: соседние отрезки строки без промежутка и пересекающиеся
+//   отрезки cur и down с разными метками (пара cur/up - при обработке строки y - 1);
+// - через границу: промежутки между отрезками cur - это пиксели границы.
+//   Для пикселя x промежутка сверху и снизу лежат отрезки up и down над ним,
+//   слева отрезок cur только у первого пикселя промежутка, справа - только у последнего.
+static void scan_run_row(AdjacencyBuilder* builder, const LabelRun* up, int up_count,
+                         const LabelRun* cur, int cur_count, const LabelRun* down, int down_count) {
+    const int width = builder->width;
+    for (int i = 1; i < cur_count; i++) {
+        if (cur[i - 1].start + cur[i - 1].length == cur[i].start) {
+            push_run_edge(builder, cur[i - 1].label, cur[i].label);
+        }
+    }
+    if (down) {
+        push_overlaps(builder, cur, cur_count, 0, down, down_count, 0, 0, width);
+    }
+    if (!up || !down) return; // Через границу - только для 1 <= y < height - 1
+
+    int up_cursor = 0;
+    int down_cursor = 0;
+    int gap_begin = 0;
+    for (int i = 0; i <= cur_count; i++) {
+        int gap_end = i < cur_count ? cur[i].start : width;
+        // Крайние столбцы изображения не рассматриваются
+        int lo = gap_begin > 1 ? gap_begin : 1;
+        int hi = gap_end < width - 1 ? gap_end : width - 1;
+        if (lo < hi) {
+            int left = gap_begin > 0 && gap_begin == lo ? cur[i - 1].label : 0;
+            int right = gap_end < width && gap_end == hi ? cur[i].label : 0;
+            if (left) {
+                int up_label = label_at(up, up_count, &up_cursor, lo);
+                int down_label = label_at(down, down_count, &down_cursor, lo);
+                if (up_label) push_run_edge(builder, left, up_label);
+                if (down_label) push_run_edge(builder, left, down_label);
+                if (right && hi - lo == 1) push_run_edge(builder, left, right);
+            }
+            // Сверху и снизу от одного пикселя границы
+            label_at(up, up_count, &up_cursor, lo);
+            label_at(down, down_count, &down_cursor, lo);
+            push_overlaps(builder, up, up_count, up_cursor, down, down_count, down_cursor, lo, hi);
+            if (right) {
+                int up_label = label_at(up, up_count, &up_cursor, hi - 1);
+                int down_label = label_at(down, down_count, &down_cursor, hi - 1);
+                if (up_label) push_run_edge(builder, right, up_label);
+                if (down_label) push_run_edge(builder, right, down_label);
+            }
+        }
+        if (i < cur_count) {
+            gap_begin = cur[i].start + cur[i].length;
+        }
+    }
+}
+// Источник отрезков: возвращает число отрезков строки y и указатель на них
+// (действителен до следующего вызова) или -1 при ошибке чтения
+typedef int (*RunSource)(void* source, int y, const LabelRun** runs);
+// Окно из отрезков трёх строк: строка y хранится в слоте y % 3
+typedef struct {
+    LabelRun* runs[3];
+    int counts[3];
+} RunWindow;
+static int load_run_row(RunWindow* window, RunSource get_runs, void* source, int y) {
+    const LabelRun* runs;
+    int count = get_runs(source, y, &runs);
+    if (count < 0) return 0;
+    memcpy(window->runs[y % 3], runs, count * sizeof(LabelRun));
+    window->counts[y % 3] = count;
+    return 1;
+}
+// Строки [y_begin, y_end) по отрезкам. Строки читаются по возрастанию, начиная с y_begin - 1.
+static void scan_run_rows(AdjacencyBuilder* builder, RunSource get_runs, void* source, int y_begin, int y_end) {
+    const int height = builder->height;
+    const int max_row_runs = (builder->width + 1) / 2;
+    RunWindow window;
+    int ok = 1;
+    for (int i = 0; i < 3; i++) {
+        window.runs[i] = (LabelRun*)malloc((max_row_runs + 1) * sizeof(LabelRun));
+        window.counts[i] = 0;
+        ok = ok && window.runs[i];
+    }
+    if (!ok) {
+        fprintf(stderr, "Failed to allocate memory for row window.\n");
+        builder->failed = 1;
+    }
+    if (ok && y_begin > 0 && !load_run_row(&window, get_runs, source, y_begin - 1)) {
+        builder->failed = 1;
+    }
+    if (ok && y_begin < y_end && !load_run_row(&window, get_runs, source, y_begin)) {
+        builder->failed = 1;
+    }
+    for (int y = y_begin; y < y_end && !builder->failed; y++) {
+        if (y + 1 < height && !load_run_row(&window, get_runs, source, y + 1)) {
+            builder->failed = 1;
+            break;
+        }
+        int up = (y + 2) % 3;
+        int down = (y + 1) % 3;
+        scan_run_row(builder, y > 0 ? window.runs[up] : NULL, window.counts[up],
+                     window.runs[y % 3], window.counts[y % 3],
+                     y + 1 < height ? window.runs[down] : NULL, window.counts[down]);
+    }
+    for (int i = 0; i < 3; i++) {
+        free(window.runs[i]);
+    }
+}
+// Параллельный обход: строки делятся на полосы, у каждой полосы свой
+// построитель со своим буфером рёбер, так что общих записей нет.
+// Источник строк - либо плотная карта (region_map), либо отрезки (get_runs).
+typedef struct {
+    AdjacencyBuilder* bands;
+    int num_bands;
+    const int* region_map;
+    const ForegroundMask* mask;
+    const BorderIndex* border_index; // Если не NULL - обход плотной карты по индексу
+    const BorderGrowth* growth;      // Если не NULL - обход проросшей карты (толстые границы)
+    RunSource get_runs;
+    void* source;
+} GraphBands;
+static void graph_band_task(void* context, int band) {
+    GraphBands* ctx = (GraphBands*)context;
+    AdjacencyBuilder* builder = &ctx->bands[band];
+    int y_begin = (int)((long)builder->height * band / ctx->num_bands);
+    int y_end = (int)((long)builder->height * (band + 1) / ctx->num_bands);
+    if (ctx->growth) {
+        scan_grown_rows(builder, ctx->growth, y_begin, y_end);
+    } else if (ctx->border_index) {
+        scan_index_rows(builder, ctx->region_map, ctx->border_index, y_begin, y_end);
+    } else if (ctx->region_map) {
+        scan_map_rows(builder, ctx->region_map, ctx->mask, y_begin, y_end);
+    } else {
+        scan_run_rows(builder, ctx->get_runs, ctx->source, y_begin, y_end);
+    }
+}
+// Сканирует все строки в num_threads потоках и сливает буферы полос в builder
+static void scan_in_bands(AdjacencyBuilder* builder, GraphBands* ctx, int num_threads) {
+    // Полос больше, чем потоков: плотность границ по высоте карты неравномерна
+    int num_bands = num_threads * 4 < builder->height ? num_threads * 4 : builder->height;
+    if (num_bands < 1) num_bands = 1;
+    ctx->num_bands = num_bands;
+    ctx->bands = (AdjacencyBuilder*)malloc(num_bands * sizeof(AdjacencyBuilder));
+    if (!ctx->bands) {
+        builder->failed = 1;
+        return;
+    }
+    for (int b = 0; b < num_bands; b++) {
+        ctx->bands[b] = *builder;
+        init_edge_buffer(&ctx->bands[b].edges);
+    }
+    parallel_for(num_bands, num_threads, graph_band_task, ctx);
+
+    long total = 0;
+    for (int b = 0; b < num_bands; b++) {
+        total += ctx->bands[b].edges.count;
+        builder->failed |= ctx->bands[b].failed | ctx->bands[b].edges.failed;
+    }
+    EdgeBuffer* merged = &builder->edges;
+    while (!builder->failed && merged->capacity < total) {
+        if (!grow_edge_buffer(merged)) builder->failed = 1;
+    }
+    for (int b = 0; b < num_bands; b++) {
+        EdgeBuffer* band_edges = &ctx->bands[b].edges;
+        if (!builder->failed) {
+            memcpy(merged->keys + merged->count, band_edges->keys, band_edges->count * sizeof(uint64_t));
+            merged->count += band_edges->count;
+        }
+        free_edge_buffer(band_edges);
+    }
+    free(ctx->bands);
+}
+Graph* build_adjacency_graph(int* region_map, const ForegroundMask* mask, const BorderIndex* border_index,
+                             int num_regions, const GraphOptions* options) {
+    AdjacencyBuilder builder;
+    init_builder(&builder, mask->width, mask->height, num_regions, options->kind);
+    BorderGrowth* growth = NULL;
+    if (options->border_width > 1) {
+        // Толстые границы: индекс не нужен, касания ищутся по проросшей карте
+        log_message("Border width: up to %d pixels\n", options->border_width);
+        growth = grow_regions_into_borders(region_map, mask->width, mask->height, options->border_width);
+        if (!growth) {
+            builder.failed = 1;
+            return finish_builder(&builder);
+        }
+        border_index = NULL;
+    } else if (border_index) {
+        log_message("Border index: %d runs, %ld pixels\n", border_index->num_runs, border_index->num_pixels);
+    }
+    if (options->num_threads > 1) {
+        GraphBands ctx = {NULL, 0, region_map, mask, border_index, growth, NULL, NULL};
+        scan_in_bands(&builder, &ctx, options->num_threads);
+    } else if (growth) {
+        scan_grown_rows(&builder, growth, 0, mask->height);
+    } else if (border_index) {
+        scan_index_rows(&builder, region_map, border_index, 0, mask->height);
+    } else {
+        scan_map_rows(&builder, region_map, mask, 0, mask->height);
+    }
+    free_border_growth(growth);
+    return finish_builder(&builder);
+}
+static int rle_row_runs(void* source, int y, const LabelRun** runs) {
+    const RunLengthMap* rle = (const RunLengthMap*)source;
+    *runs = rle->runs + rle->row_start[y];
+    return rle->row_start[y + 1] - rle->row_start[y];
+}
+// Граф по отрезкам: работа пропорциональна числу отрезков, а не пикселей
+Graph* build_adjacency_graph_rle(const RunLengthMap* rle, int num_regions, const GraphOptions* options) {
+    AdjacencyBuilder builder;
+    init_builder(&builder, rle->width, rle->height, num_regions, options->kind);
+    // Строки RLE-карты доступны в любом порядке, поэтому полосы независимы
+    if (options->num_threads > 1) {
+        GraphBands ctx = {NULL, 0, NULL, NULL, NULL, NULL, rle_row_runs, (void*)rle};
+        scan_in_bands(&builder, &ctx, options->num_threads);
+    } else {
+        scan_run_rows(&builder, rle_row_runs, (void*)rle, 0, rle->height);
+    }
+    return finish_builder(&builder);
+}
+static int streamed_row_runs(void* source, int y, const LabelRun** runs) {
+    return streamed_read_row((StreamedRegions*)source, y, runs);
+}
+// Временный файл читается только последовательно, поэтому здесь один поток
+Graph* build_adjacency_graph_streamed(StreamedRegions* regions, int num_regions, const GraphOptions* options) {
+    AdjacencyBuilder builder;
+    init_builder(&builder, regions->width, regions->height, num_regions, options->kind);
+    scan_run_rows(&builder, streamed_row_runs, regions, 0, regions->height);
+    return finish_builder(&builder);
 }
\ No newline at end of file
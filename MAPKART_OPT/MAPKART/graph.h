@@ -2,15 +2,67 @@
 #define GRAPH_H
 
 #include <stdlib.h>
+#include "foreground_mask.h"
+#include "run_length_map.h"
+#include "region_detector.h"
+
+// Представление графа смежности
+typedef enum {
+    GRAPH_DENSE = 0, // Матрица int num_vertices x num_vertices
+    GRAPH_CSR,       // Сжатые списки смежности (compressed sparse row)
+    GRAPH_BITSET     // Битовая матрица: один бит на пару вершин
+} GraphKind;
 
 typedef struct {
-    int** matrix;
+    GraphKind kind;
     int num_vertices;
+    int num_edges;
+    int** matrix;   // GRAPH_DENSE: matrix[v][u] = 1, если v и u соседи
+    int* offsets;   // GRAPH_CSR: соседи v - neighbors[offsets[v]] .. neighbors[offsets[v + 1] - 1]
+    int* neighbors; // GRAPH_CSR: 2 * num_edges элементов, по возрастанию внутри вершины
+    uint64_t* bits; // GRAPH_BITSET: строка v - words_per_row слов с bits + v * words_per_row
+    int words_per_row;
 } Graph;
 
+// Ребро между регионами u < v
+typedef struct {
+    int u;
+    int v;
+} Edge;
+
 Graph* create_graph(int num_vertices);
+// Строит граф нужного вида по списку различных рёбер (u < v)
+Graph* create_graph_from_edges(int num_vertices, const Edge* edges, int num_edges, GraphKind kind);
 void free_graph(Graph* graph);
+// Только для GRAPH_DENSE и GRAPH_BITSET: CSR-граф после построения не изменяется
 void add_edge(Graph* graph, int v1, int v2);
-Graph* build_adjacency_graph(int* region_map, int width, int height, int num_regions);
+// Есть ли ребро v1 - v2 (для любого вида графа)
+int graph_has_edge(const Graph* graph, int v1, int v2);
+// Список рёбер (u < v) по возрастанию (u, v) для любого вида графа.
+// Возвращает NULL при нехватке памяти.
+Edge* graph_edge_list(const Graph* graph, int* num_edges);
+// Граф в виде CSR для алгоритмов, которым нужны списки соседей: сам graph,
+// если он уже CSR, иначе копия, которую нужно освободить через *owned.
+// Возвращает NULL при нехватке памяти.
+const Graph* graph_csr_view(const Graph* graph, Graph** owned);
+// Строка битовой матрицы вершины v (GRAPH_BITSET)
+static inline uint64_t* graph_bit_row(const Graph* graph, int v) {
+    return graph->bits + (size_t)v * graph->words_per_row;
+}
+
+typedef struct {
+    GraphKind kind;
+    int num_threads; // > 1 - строки сканируются полосами в нескольких потоках
+    int border_width; // > 1 - регионы через границу толщиной до border_width пикселей
+                      // тоже соседи (только плотная карта, см. border_growth.h)
+} GraphOptions;
+
+// Если border_index не NULL, просматриваются только пиксели границы из индекса
+// (см. border_index.h), иначе - переходы меток во всех строках карты
+Graph* build_adjacency_graph(int* region_map, const ForegroundMask* mask, const BorderIndex* border_index,
+                             int num_regions, const GraphOptions* options);
+Graph* build_adjacency_graph_rle(const RunLengthMap* rle, int num_regions, const GraphOptions* options);
+// Потоковый вариант: строки читаются из временного файла find_regions_streaming()
+Graph* build_adjacency_graph_streamed(StreamedRegions* regions, int num_regions, const GraphOptions* options);
 
 #endif // GRAPH_H
\ No newline at end of file
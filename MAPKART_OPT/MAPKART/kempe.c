@@ -0,0 +1,405 @@
+#include "kempe.h"
+#include <stdio.h>
+#include "colorizer.h"
+#include "exact_coloring.h"
+#include "utils.h"
+
+// Ограничения, чтобы стоимость ремонта оставалась пропорциональной окрестности
+#define KEMPE_MAX_CHAIN 4096      // Вершин в одной цепи Кемпе
+#define REPAIR_MAX_DEPTH 3        // Глубина перекрашивания соседей
+#define REPAIR_MAX_CONFLICTS 2    // Конфликтующих соседей на одном уровне перебора
+#define REPAIR_STEP_BUDGET 20000  // Попыток цвета на одну вершину
+#define REPAIR_BALL_RADIUS 2      // Начальный радиус шара точного поиска (удваивается)
+#define REPAIR_BALL_MAX 1024      // Вершин в шаре точного поиска
+#define REPAIR_BALL_BUDGET 0.005  // Секунд точного поиска на один шар
+#define REPAIR_EXACT_BUDGET 0.05  // Секунд точного поиска на весь ремонт
+
+typedef struct {
+    const Graph* csr;
+    int* colors;
+    int max_colors;
+    int* mark;        // mark[v] == epoch - вершина уже в текущей цепи
+    int* neighbor_of; // neighbor_of[v] == epoch_v - сосед ремонтируемой вершины
+    int epoch;
+    int* chain;
+    unsigned char* locked; // Вершины на текущем пути перебора
+    int* undo_vertex;      // Журнал изменений цвета для отката перебора
+    int* undo_color;
+    int undo_count;
+    int undo_capacity;
+    long budget;
+    int* ball;             // Вершины шара точного поиска в порядке обхода
+    int* local_index;      // Номер вершины шара в подграфе (0 - не входит)
+    double exact_budget;   // Остаток бюджета точного поиска, секунды
+} ColorRepair;
+
+// Маска цветов соседей v (бит c - 1)
+static inline unsigned neighbor_colors(const ColorRepair* repair, int v) {
+    unsigned used = 0;
+    for (int k = repair->csr->offsets[v]; k < repair->csr->offsets[v + 1]; k++) {
+        int c = repair->colors[repair->csr->neighbors[k]];
+        if (c > 0) used |= 1u << (c - 1);
+    }
+    return used;
+}
+
+// Перестановка (a, b)-цепи для вершины v: цепь строится обходом в ширину от
+// всех соседей v цвета a по вершинам цветов a и b. Если в неё не попал ни один
+// сосед v цвета b, цвета цепи меняются местами и v получает цвет a.
+static int try_kempe_swap(ColorRepair* repair, int v, int a, int b) {
+    const Graph* csr = repair->csr;
+    int* colors = repair->colors;
+    int epoch = ++repair->epoch;
+    int length = 0;
+    for (int k = csr->offsets[v]; k < csr->offsets[v + 1]; k++) {
+        int u = csr->neighbors[k];
+        repair->neighbor_of[u] = epoch;
+        if (colors[u] == a && repair->mark[u] != epoch) {
+            if (length == KEMPE_MAX_CHAIN) return 0;
+            repair->mark[u] = epoch;
+            repair->chain[length++] = u;
+        }
+    }
+    for (int head = 0; head < length; head++) {
+        int w = repair->chain[head];
+        for (int k = csr->offsets[w]; k < csr->offsets[w + 1]; k++) {
+            int u = csr->neighbors[k];
+            if (repair->mark[u] == epoch || (colors[u] != a && colors[u] != b)) continue;
+            // Сосед v цвета b в той же цепи: после перестановки он станет цветом a
+            if (colors[u] == b && repair->neighbor_of[u] == epoch) return 0;
+            if (length == KEMPE_MAX_CHAIN) return 0;
+            repair->mark[u] = epoch;
+            repair->chain[length++] = u;
+        }
+    }
+    for (int i = 0; i < length; i++) {
+        int w = repair->chain[i];
+        colors[w] = colors[w] == a ? b : a;
+    }
+    colors[v] = a;
+    log_message("  Vertex %d: Kempe chain (%d, %d) of %d vertices swapped, color %d\n", v, a, b, length, a);
+    return 1;
+}
+
+static int set_color(ColorRepair* repair, int v, int color) {
+    if (repair->undo_count == repair->undo_capacity) {
+        int capacity = repair->undo_capacity ? repair->undo_capacity * 2 : 256;
+        int* vertices = (int*)realloc(repair->undo_vertex, capacity * sizeof(int));
+        if (vertices) repair->undo_vertex = vertices;
+        int* colors = (int*)realloc(repair->undo_color, capacity * sizeof(int));
+        if (colors) repair->undo_color = colors;
+        if (!vertices || !colors) return 0;
+        repair->undo_capacity = capacity;
+    }
+    repair->undo_vertex[repair->undo_count] = v;
+    repair->undo_color[repair->undo_count] = repair->colors[v];
+    repair->undo_count++;
+    repair->colors[v] = color;
+    return 1;
+}
+
+static void undo_to(ColorRepair* repair, int count) {
+    while (repair->undo_count > count) {
+        repair->undo_count--;
+        int v = repair->undo_vertex[repair->undo_count];
+        repair->colors[v] = repair->undo_color[repair->undo_count];
+        repair->locked[v] = 0;
+    }
+}
+
+// Перебор с возвратом: v (без цвета) получает цвет c, соседи цвета c
+// (не больше REPAIR_MAX_CONFLICTS, не из текущего пути) перекрашиваются рекурсивно.
+// Сначала пробуются свободные цвета, потом - с наименьшим числом конфликтов.
+// Возвращает 1 - раскрашено, 0 - нет, -1 - нехватка памяти (изменения откачены).
+static int recolor(ColorRepair* repair, int v, int depth) {
+    const Graph* csr = repair->csr;
+    int conflicts[5] = {0, 0, 0, 0, 0};
+    unsigned blocked = 0; // Цвета, занятые вершинами пути
+    for (int k = csr->offsets[v]; k < csr->offsets[v + 1]; k++) {
+        int u = csr->neighbors[k];
+        int c = repair->colors[u];
+        if (c == 0) continue;
+        conflicts[c]++;
+        if (repair->locked[u]) blocked |= 1u << c;
+    }
+    for (int allowed = 0; allowed <= REPAIR_MAX_CONFLICTS; allowed++) {
+        for (int c = 1; c <= repair->max_colors; c++) {
+            if (conflicts[c] != allowed || (blocked & (1u << c))) continue;
+            if (allowed > 0 && depth == 0) continue;
+            if (--repair->budget < 0) return 0;
+            int mark = repair->undo_count;
+            if (!set_color(repair, v, c)) return -1;
+            repair->locked[v] = 1;
+            int ok = 1;
+            for (int k = csr->offsets[v]; k < csr->offsets[v + 1] && ok == 1; k++) {
+                int u = csr->neighbors[k];
+                if (repair->colors[u] != c) continue;
+                ok = set_color(repair, u, 0) ? recolor(repair, u, depth - 1) : -1;
+            }
+            if (ok == 1) return 1;
+            undo_to(repair, mark);
+            if (ok < 0) return -1;
+        }
+    }
+    return 0;
+}
+
+// Точная раскраска шара радиуса radius вокруг v, когда локальный ремонт не
+// помог: перестановки цепей и перебор ограничены и могут не найти раскраску,
+// которая существует. Вершины ближе radius перекрашиваются, раскрашенные
+// вершины на расстоянии radius сохраняют цвета: их закрепляет палитра - клика
+// из max_colors вершин, где вершина границы цвета c соединена со всеми
+// вершинами палитры, кроме c-й. Если pin == 0, граница не закрепляется и
+// цвета не меняются: поиск только проверяет, раскрашивается ли шар вообще.
+// *boundary - число закреплённых вершин (0 - EXACT_NOT_COLORABLE доказывает,
+// что компонента не раскрашивается). Шар больше REPAIR_BALL_MAX вершин и
+// исчерпанный бюджет (шара или всего ремонта) - EXACT_TIMEOUT.
+static ExactResult repair_ball_exactly(ColorRepair* repair, int v, int radius, int pin, int* boundary) {
+    const Graph* csr = repair->csr;
+    int* colors = repair->colors;
+    int* ball = repair->ball;
+    int* local_index = repair->local_index;
+    *boundary = 0;
+    if (repair->exact_budget <= 0) return EXACT_TIMEOUT;
+
+    int epoch = ++repair->epoch;
+    int count = 0;
+    int layer_start = 0;
+    repair->mark[v] = epoch;
+    ball[count++] = v;
+    for (int d = 0; d < radius && layer_start < count; d++) {
+        int layer_end = count;
+        for (int head = layer_start; head < layer_end; head++) {
+            int w = ball[head];
+            for (int k = csr->offsets[w]; k < csr->offsets[w + 1]; k++) {
+                int u = csr->neighbors[k];
+                if (repair->mark[u] == epoch) continue;
+                if (count == REPAIR_BALL_MAX) return EXACT_TIMEOUT;
+                repair->mark[u] = epoch;
+                ball[count++] = u;
+            }
+        }
+        layer_start = layer_end;
+    }
+    // ball[0 .. layer_start) - внутренние вершины, дальше - граница.
+    // Вершины границы без цвета ничего не ограничивают и в шар не входят.
+    int num_fixed = 0;
+    for (int i = layer_start; i < count && pin; i++) {
+        if (colors[ball[i]] > 0) num_fixed++;
+    }
+    int palette = num_fixed > 0 ? repair->max_colors : 0;
+    int num_local = palette + layer_start + num_fixed;
+    int next_fixed = palette + layer_start + 1;
+    long max_edges = (long)palette * (palette - 1) / 2 + (long)palette * num_fixed;
+    for (int i = 0; i < layer_start; i++) {
+        local_index[ball[i]] = palette + i + 1;
+        max_edges += csr->offsets[ball[i] + 1] - csr->offsets[ball[i]];
+    }
+    for (int i = layer_start; i < count; i++) {
+        local_index[ball[i]] = pin && colors[ball[i]] > 0 ? next_fixed++ : 0;
+    }
+
+    // Рёбра (u < v) по возрастанию u, внутри u - по возрастанию v
+    Edge* edges = (Edge*)malloc((max_edges + 1) * sizeof(Edge));
+    if (!edges) return EXACT_FAILED;
+    int e = 0;
+    for (int p = 1; p <= palette; p++) {
+        for (int q = p + 1; q <= palette; q++) {
+            edges[e].u = p;
+            edges[e].v = q;
+            e++;
+        }
+        for (int i = layer_start; i < count; i++) {
+            int u = ball[i];
+            if (local_index[u] == 0 || colors[u] == p) continue;
+            edges[e].u = p;
+            edges[e].v = local_index[u];
+            e++;
+        }
+    }
+    for (int i = 0; i < layer_start; i++) {
+        int w = ball[i];
+        int first = e;
+        for (int k = csr->offsets[w]; k < csr->offsets[w + 1]; k++) {
+            int u = csr->neighbors[k];
+            if (local_index[u] <= local_index[w]) continue;
+            // Вставка: соседей в шаре мало
+            int j = e++;
+            while (j > first && edges[j - 1].v > local_index[u]) {
+                edges[j] = edges[j - 1];
+                j--;
+            }
+            edges[j].u = local_index[w];
+            edges[j].v = local_index[u];
+        }
+    }
+    Graph* subgraph = create_graph_from_edges(num_local + 1, edges, e, GRAPH_CSR);
+    free(edges);
+    int* sub_colors = subgraph ? (int*)malloc((num_local + 1) * sizeof(int)) : NULL;
+    if (!sub_colors) {
+        free_graph(subgraph);
+        return EXACT_FAILED;
+    }
+    Timer timer;
+    start_timer(&timer);
+    double budget = repair->exact_budget < REPAIR_BALL_BUDGET ? repair->exact_budget : REPAIR_BALL_BUDGET;
+    ExactResult result = exact_k_coloring(subgraph, repair->max_colors, budget, sub_colors);
+    stop_timer(&timer);
+    repair->exact_budget -= get_duration(&timer);
+    if (result == EXACT_COLORABLE && pin) {
+        // Цвета найденной раскраски равноправны: цвет вершины палитры p - это цвет p
+        int color_of[5] = {0, 1, 2, 3, 4};
+        for (int p = 1; p <= palette; p++) {
+            color_of[sub_colors[p]] = p;
+        }
+        for (int i = 0; i < layer_start; i++) {
+            colors[ball[i]] = color_of[sub_colors[palette + i + 1]];
+        }
+    }
+    free(sub_colors);
+    free_graph(subgraph);
+    *boundary = num_fixed;
+    return result;
+}
+
+int repair_coloring(const Graph* csr, int max_colors, int* colors, const int* uncolored, int num_uncolored) {
+    int n = csr->num_vertices;
+    ColorRepair repair;
+    repair.csr = csr;
+    repair.colors = colors;
+    repair.max_colors = max_colors;
+    repair.mark = (int*)calloc(n, sizeof(int));
+    repair.neighbor_of = (int*)calloc(n, sizeof(int));
+    repair.chain = (int*)malloc((KEMPE_MAX_CHAIN + 1) * sizeof(int));
+    repair.locked = (unsigned char*)calloc(n, 1);
+    repair.epoch = 0;
+    repair.undo_vertex = NULL;
+    repair.undo_color = NULL;
+    repair.undo_count = 0;
+    repair.undo_capacity = 0;
+    repair.ball = (int*)malloc(REPAIR_BALL_MAX * sizeof(int));
+    repair.local_index = (int*)malloc(n * sizeof(int));
+    repair.exact_budget = REPAIR_EXACT_BUDGET;
+    if (!repair.mark || !repair.neighbor_of || !repair.chain || !repair.locked ||
+        !repair.ball || !repair.local_index) {
+        fprintf(stderr, "Failed to allocate memory for coloring repair.\n");
+        free(repair.mark);
+        free(repair.neighbor_of);
+        free(repair.chain);
+        free(repair.locked);
+        free(repair.ball);
+        free(repair.local_index);
+        return -1;
+    }
+
+    const unsigned all_colors = (1u << max_colors) - 1;
+    int failed = 0;
+    for (int i = 0; i < num_uncolored; i++) {
+        int v = uncolored[i];
+        if (colors[v]) continue; // Раскрашена точным поиском вместе с шаром другой вершины
+        // Соседи могли перекраситься при ремонте других вершин
+        unsigned used = neighbor_colors(&repair, v);
+        if (used != all_colors) {
+            colors[v] = lowest_bit_index(~used & all_colors) + 1;
+            log_message("  Vertex %d: color %d became free\n", v, colors[v]);
+            continue;
+        }
+        int repaired = 0;
+        for (int a = 1; a <= max_colors && !repaired; a++) {
+            for (int b = 1; b <= max_colors && !repaired; b++) {
+                if (a != b) repaired = try_kempe_swap(&repair, v, a, b);
+            }
+        }
+        if (!repaired) {
+            repair.budget = REPAIR_STEP_BUDGET;
+            repair.undo_count = 0;
+            repaired = recolor(&repair, v, REPAIR_MAX_DEPTH);
+            if (repaired < 0) {
+                failed = 1;
+                break;
+            }
+            // Удачный путь остаётся в силе, снимаются только блокировки
+            for (int k = 0; k < repair.undo_count; k++) {
+                repair.locked[repair.undo_vertex[k]] = 0;
+            }
+            if (repaired) {
+                log_message("  Vertex %d: recolored with %d changes, color %d\n", v, repair.undo_count, colors[v]);
+            }
+        }
+        ExactResult exact = EXACT_TIMEOUT;
+        if (!repaired) {
+            // Шар растёт, пока его граница мешает раскраске
+            int radius = REPAIR_BALL_RADIUS;
+            int boundary = 0;
+            for (;; radius *= 2) {
+                exact = repair_ball_exactly(&repair, v, radius, 1, &boundary);
+                if (exact != EXACT_NOT_COLORABLE || boundary == 0) break;
+                if (radius == REPAIR_BALL_RADIUS) {
+                    // Если малая окрестность не раскрашивается и без закреплённой
+                    // границы, max_colors цветов мало всей компоненте - шар не растёт
+                    ExactResult free_ball = repair_ball_exactly(&repair, v, radius, 0, &boundary);
+                    if (free_ball != EXACT_COLORABLE) {
+                        exact = free_ball;
+                        break;
+                    }
+                }
+            }
+            if (exact == EXACT_FAILED) {
+                failed = 1;
+                break;
+            }
+            repaired = exact == EXACT_COLORABLE;
+            if (repaired) {
+                log_message("  Vertex %d: neighborhood of radius %d recolored by exact search, color %d\n",
+                            v, radius, colors[v]);
+            }
+        }
+        if (!repaired) {
+            // Компонента не раскрашивается в max_colors цветов (или ограниченный
+            // поиск не нашёл раскраску) - цвет с наименьшим числом конфликтов
+            int conflicts[5] = {0, 0, 0, 0, 0};
+            for (int k = csr->offsets[v]; k < csr->offsets[v + 1]; k++) {
+                conflicts[colors[csr->neighbors[k]]]++;
+            }
+            int best = 1;
+            for (int c = 2; c <= max_colors; c++) {
+                if (conflicts[c] < conflicts[best]) best = c;
+            }
+            colors[v] = best;
+            if (exact == EXACT_NOT_COLORABLE) {
+                log_message("  -> WARNING: Component of vertex %d cannot be colored with %d colors! Using color %d (%d conflicts).\n",
+                            v, max_colors, best, conflicts[best]);
+            } else {
+                log_message("  -> WARNING: Bounded search found no %d-coloring around vertex %d! Using color %d (%d conflicts).\n",
+                            max_colors, v, best, conflicts[best]);
+            }
+        }
+    }
+
+    // Шар точного поиска мог исправить и вершину, оставленную с конфликтом раньше
+    int unresolved = -1;
+    if (!failed) {
+        unresolved = 0;
+        for (int i = 0; i < num_uncolored; i++) {
+            int v = uncolored[i];
+            for (int k = csr->offsets[v]; k < csr->offsets[v + 1]; k++) {
+                if (colors[csr->neighbors[k]] == colors[v]) {
+                    unresolved++;
+                    break;
+                }
+            }
+        }
+    } else {
+        fprintf(stderr, "Failed to allocate memory for coloring repair.\n");
+    }
+
+    free(repair.mark);
+    free(repair.neighbor_of);
+    free(repair.chain);
+    free(repair.locked);
+    free(repair.undo_vertex);
+    free(repair.undo_color);
+    free(repair.ball);
+    free(repair.local_index);
+    return unresolved;
+}
\ No newline at end of file
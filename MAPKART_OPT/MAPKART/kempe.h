@@ -0,0 +1,26 @@
+#ifndef KEMPE_H
+#define KEMPE_H
+
+#include "graph.h"
+
+// Дораскраска вершин, которым жадный алгоритм не нашёл свободного цвета
+// (colors[v] == 0 для всех v из uncolored). Для каждой такой вершины:
+// 1. перестановка цепи Кемпе: связная (a, b)-компонента, содержащая соседей
+//    вершины цвета a, но не соседей цвета b, меняет цвета a <-> b, и цвет a
+//    освобождается; перебираются все пары цветов, цепь ограничена по длине;
+// 2. если одной перестановки мало - перебор с возвратом ограниченной глубины:
+//    вершина получает цвет, а конфликтующие соседи перекрашиваются рекурсивно;
+// 3. если и это не помогло (оба поиска ограничены) - точный поиск
+//    max_colors-раскраски шара вокруг вершины (exact_coloring.h): вершины
+//    ближе радиуса перекрашиваются, граница сохраняет цвета; радиус
+//    удваивается, пока граница мешает и шар не больше 1024 вершин;
+// 4. если раскраска не нашлась - цвет с наименьшим числом конфликтов
+//    (граф касаний через границу не обязательно планарен).
+// Работает по спискам соседей csr. Стоимость шагов 1-2 ограничена на вершину,
+// шага 3 - размером шара и общим бюджетом 0.05 секунды на весь ремонт,
+// поэтому ремонт не пересчитывает раскраску всей компоненты.
+// Возвращает число вершин из uncolored, оставшихся с конфликтом, или -1 при
+// нехватке памяти.
+int repair_coloring(const Graph* csr, int max_colors, int* colors, const int* uncolored, int num_uncolored);
+
+#endif // KEMPE_H
\ No newline at end of file
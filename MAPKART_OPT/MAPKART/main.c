@@ -6,6 +6,9 @@
 #include "graph.h"
 #include "colorizer.h"
 #include "utils.h"
+#include "parallel.h"
+#include "border_growth.h"
+#include "vertex_order.h"
 
 static int should_disable_logging() {
     char response[8];
@@ -30,74 +33,279 @@ static int should_disable_logging() {
     }
 }
 
-int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        fprintf(stderr, "Usage: %s <input_file.bmp> <output_file.bmp>\n", argv[0]);
-        return 1;
-    }
+// Параметры запуска, задаваемые после имён файлов
+typedef struct {
+    LabelingEngine labeling;
+    int num_threads;
+    int use_runs; // Хранить карту регионов отрезками (RLE) вместо int на пиксель
+    int stream;   // Обрабатывать изображение построчно, не загружая его целиком
+    GraphKind graph_kind;
+    int border_width; // Наибольшая толщина границы между соседними регионами
+    VertexOrder vertex_order;
+    ColoringEngine coloring;
+    int peel_low_degree; // Красить вершины степени < 4 после ядра графа
+    double exact_time_budget; // > 0 - точная минимальная раскраска с этим общим бюджетом
+} Options;
 
-    const char* input_fn = argv[1];
-    const char* output_fn = argv[2];
+static void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s <input_file.bmp> <output_file.bmp> [options]\n", program);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --labeling scanline|two-pass   region labeling algorithm (default: two-pass,\n");
+    fprintf(stderr, "                                 labeled in --threads bands)\n");
+    fprintf(stderr, "  --threads N                    worker threads for parallel stages (default: CPU count)\n");
+    fprintf(stderr, "  --label-map dense|rle          region map storage: int per pixel or row runs (default: dense)\n");
+    fprintf(stderr, "  --stream                       process the image row by row, spilling label runs to disk\n");
+    fprintf(stderr, "  --graph dense|csr|bitset       adjacency graph storage (default: csr)\n");
+    fprintf(stderr, "  --border-width N               regions up to N border pixels apart are neighbors (default: 1,\n");
+    fprintf(stderr, "                                 N > 1 needs the dense label map)\n");
+    fprintf(stderr, "  --vertex-order none|bfs|rcm    renumber graph vertices before coloring (default: none)\n");
+    fprintf(stderr, "  --coloring smallest-last|welsh-powell|dsatur|jones-plassmann\n");
+    fprintf(stderr, "                                 graph coloring algorithm (default: smallest-last)\n");
+    fprintf(stderr, "  --peel on|off                  color vertices of degree < 4 after the rest of the graph (default: on)\n");
+    fprintf(stderr, "  --exact SECONDS                find the minimum number of colors by branch and bound,\n");
+    fprintf(stderr, "                                 spending at most SECONDS in total\n");
+}
 
-    int logging_disabled = should_disable_logging();
+static int parse_options(int argc, char* argv[], Options* options) {
+    options->labeling = LABELING_TWO_PASS;
+    options->num_threads = get_cpu_count();
+    options->use_runs = 0;
+    options->stream = 0;
+    options->graph_kind = GRAPH_CSR;
+    options->border_width = 1;
+    options->vertex_order = VERTEX_ORDER_NONE;
+    options->coloring = COLORING_SMALLEST_LAST;
+    options->peel_low_degree = 1;
+    options->exact_time_budget = 0;
 
-    char log_filename[256] = {0};
-    if (!logging_disabled) {
-        snprintf(log_filename, sizeof(log_filename), "map_coloring_log_%s.txt", output_fn);
-        init_logging(log_filename);
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--labeling") == 0 && i + 1 < argc) {
+            const char* value = argv[++i];
+            if (strcmp(value, "scanline") == 0) {
+                options->labeling = LABELING_SCANLINE;
+            } else if (strcmp(value, "two-pass") == 0) {
+                options->labeling = LABELING_TWO_PASS;
+            } else {
+                fprintf(stderr, "Unknown labeling algorithm: %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options->num_threads = atoi(argv[++i]);
+            if (options->num_threads < 1) {
+                fprintf(stderr, "Thread count must be a positive number.\n");
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--label-map") == 0 && i + 1 < argc) {
+            const char* value = argv[++i];
+            if (strcmp(value, "dense") == 0) {
+                options->use_runs = 0;
+            } else if (strcmp(value, "rle") == 0) {
+                options->use_runs = 1;
+            } else {
+                fprintf(stderr, "Unknown label map format: %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--graph") == 0 && i + 1 < argc) {
+            const char* value = argv[++i];
+            if (strcmp(value, "dense") == 0) {
+                options->graph_kind = GRAPH_DENSE;
+            } else if (strcmp(value, "csr") == 0) {
+                options->graph_kind = GRAPH_CSR;
+            } else if (strcmp(value, "bitset") == 0) {
+                options->graph_kind = GRAPH_BITSET;
+            } else {
+                fprintf(stderr, "Unknown graph format: %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--border-width") == 0 && i + 1 < argc) {
+            options->border_width = atoi(argv[++i]);
+            if (options->border_width < 1 || options->border_width > BORDER_MAX_WIDTH) {
+                fprintf(stderr, "Border width must be between 1 and %d.\n", BORDER_MAX_WIDTH);
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--vertex-order") == 0 && i + 1 < argc) {
+            const char* value = argv[++i];
+            if (strcmp(value, "none") == 0) {
+                options->vertex_order = VERTEX_ORDER_NONE;
+            } else if (strcmp(value, "bfs") == 0) {
+                options->vertex_order = VERTEX_ORDER_BFS;
+            } else if (strcmp(value, "rcm") == 0) {
+                options->vertex_order = VERTEX_ORDER_RCM;
+            } else {
+                fprintf(stderr, "Unknown vertex order: %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--coloring") == 0 && i + 1 < argc) {
+            const char* value = argv[++i];
+            if (strcmp(value, "smallest-last") == 0) {
+                options->coloring = COLORING_SMALLEST_LAST;
+            } else if (strcmp(value, "welsh-powell") == 0) {
+                options->coloring = COLORING_WELSH_POWELL;
+            } else if (strcmp(value, "dsatur") == 0) {
+                options->coloring = COLORING_DSATUR;
+            } else if (strcmp(value, "jones-plassmann") == 0) {
+                options->coloring = COLORING_JONES_PLASSMANN;
+            } else {
+                fprintf(stderr, "Unknown coloring algorithm: %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--peel") == 0 && i + 1 < argc) {
+            const char* value = argv[++i];
+            if (strcmp(value, "on") == 0) {
+                options->peel_low_degree = 1;
+            } else if (strcmp(value, "off") == 0) {
+                options->peel_low_degree = 0;
+            } else {
+                fprintf(stderr, "Unknown peel mode: %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--exact") == 0 && i + 1 < argc) {
+            options->exact_time_budget = atof(argv[++i]);
+            if (options->exact_time_budget <= 0) {
+                fprintf(stderr, "Exact coloring time budget must be a positive number of seconds.\n");
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            options->stream = 1;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 0;
+        }
     }
-    
-    log_message("MAP COLORING PROCESS STARTED\n");
-    log_message("============================\n");
-    log_message("Input file: %s\n", input_fn);
-    log_message("Output file: %s\n", output_fn);
-    if (!logging_disabled) {
-        log_message("Log file: %s\n", log_filename);
+    if (options->border_width > 1 && (options->use_runs || options->stream)) {
+        fprintf(stderr, "Border width above 1 needs the dense label map.\n");
+        return 0;
     }
+    return 1;
+}
 
-    Timer total_timer, coloring_timer;
-    start_timer(&total_timer);
+// Раскрашивает граф, при необходимости перенумеровав вершины для локальности
+// доступа к памяти. Цвета возвращаются в исходной нумерации регионов.
+static int* color_regions(const Options* options, Graph* graph, ColoringSummary* summary, Timer* coloring_timer) {
+    Graph* ordered = graph;
+    int* new_to_old = NULL;
+    if (options->vertex_order != VERTEX_ORDER_NONE) {
+        ordered = reorder_graph(graph, options->vertex_order, &new_to_old);
+        if (!ordered) return NULL;
+    }
+
+    ColoringOptions coloring_options;
+    coloring_options.engine = options->coloring;
+    coloring_options.num_threads = options->num_threads;
+    coloring_options.peel_low_degree = options->peel_low_degree;
+    coloring_options.exact_time_budget = options->exact_time_budget;
+    start_timer(coloring_timer);
+    int* colors = color_graph(ordered, &coloring_options, summary);
+    stop_timer(coloring_timer);
+
+    if (new_to_old) {
+        if (colors && !restore_vertex_order(colors, new_to_old, graph->num_vertices)) {
+            free(colors);
+            colors = NULL;
+        }
+        free(new_to_old);
+        free_graph(ordered);
+    }
+    return colors;
+}
 
+// Обычный режим: изображение и карта регионов целиком в памяти
+static int run_in_memory(const Options* options, const char* input_fn, const char* output_fn,
+                         ColoringSummary* summary, Timer* coloring_timer) {
     log_message("\nSTEP -1: Reading BMP file\n");
     log_message("=========================\n");
     printf("Reading BMP file: %s\n", input_fn);
     BMPImage* image = read_bmp(input_fn);
     if (!image) {
         log_message("ERROR: Failed to read BMP file\n");
-        close_logging();
-        return 1;
+        return 0;
     }
     log_message("BMP file read successfully\n");
     log_message("Image dimensions: %d x %d pixels\n", image->info_header.width, image->info_header.height);
 
     log_message("\nSTEP -2: Region detection\n");
     log_message("=========================\n");
+    ForegroundMask* mask = build_foreground_mask(image, options->num_threads);
+    if (!mask) {
+        log_message("ERROR: Failed to classify pixels\n");
+        free_bmp(image);
+        return 0;
+    }
     int region_count = 0;
-    int* region_map = find_regions(image, &region_count);
-    if (!region_map) {
+    int* region_map = NULL;
+    RunLengthMap* region_runs = NULL;
+    RegionStats* region_stats = NULL;
+    BorderIndex* border_index = NULL;
+    if (options->use_runs) {
+        region_runs = find_regions_rle(mask, &region_count, &region_stats);
+    } else {
+        LabelingOptions labeling_options;
+        labeling_options.engine = options->labeling;
+        labeling_options.num_threads = options->num_threads;
+        // Толстым границам индекс не нужен: касания ищутся по проросшей карте
+        region_map = find_regions(mask, &region_count, &labeling_options, &region_stats,
+                                  options->border_width == 1 ? &border_index : NULL);
+    }
+    if (!region_map && !region_runs) {
         log_message("ERROR: Failed to detect regions\n");
+        free_foreground_mask(mask);
         free_bmp(image);
-        close_logging();
-        return 1;
+        return 0;
     }
     printf("Found %d regions.\n", region_count);
     log_message("Region detection completed successfully\n");
     log_message("Total regions found: %d\n", region_count);
+    if (region_runs) {
+        log_message("Label map: %d runs, %ld bytes (dense map would take %ld bytes)\n",
+                    region_runs->num_runs,
+                    (long)region_runs->num_runs * sizeof(LabelRun) + (long)(region_runs->height + 1) * sizeof(int),
+                    (long)region_runs->width * region_runs->height * sizeof(int));
+    }
+    if (border_index) {
+        log_message("Border index: %ld of %ld pixels\n", border_index->num_pixels,
+                    (long)border_index->width * border_index->height);
+    }
+    log_region_stats(region_stats, region_count);
 
     printf("Building adjacency graph...\n");
-    Graph* graph = build_adjacency_graph(region_map, image->info_header.width, image->info_header.height, region_count);
+    GraphOptions graph_options;
+    graph_options.kind = options->graph_kind;
+    graph_options.num_threads = options->num_threads;
+    graph_options.border_width = options->border_width;
+    Graph* graph = region_runs ? build_adjacency_graph_rle(region_runs, region_count, &graph_options)
+                               : build_adjacency_graph(region_map, mask, border_index, region_count, &graph_options);
+    free_border_index(border_index);
+    if (!graph) {
+        log_message("ERROR: Failed to build adjacency graph\n");
+        free(region_map);
+        free(region_stats);
+        free_run_length_map(region_runs);
+        free_foreground_mask(mask);
+        free_bmp(image);
+        return 0;
+    }
 
     printf("Coloring graph...\n");
-    int num_colors = 0;
-
-    start_timer(&coloring_timer);
-    int* colors = color_graph(graph, &num_colors);
-    stop_timer(&coloring_timer);
+    int* colors = color_regions(options, graph, summary, coloring_timer);
+    if (!colors) {
+        log_message("ERROR: Failed to color graph\n");
+        free_graph(graph);
+        free(region_map);
+        free(region_stats);
+        free_run_length_map(region_runs);
+        free_foreground_mask(mask);
+        free_bmp(image);
+        return 0;
+    }
 
     printf("Coloring complete.\n");
 
     printf("Applying colors to image...\n");
-    apply_colors_to_image(image, region_map, colors);
+    if (region_runs) {
+        apply_colors_rle(image, region_runs, colors);
+    } else {
+        apply_colors_to_image(image, mask, region_map, colors);
+    }
 
     printf("Writing output file: %s\n", output_fn);
     if (!write_bmp(output_fn, image)) {
@@ -107,16 +315,131 @@ int main(int argc, char* argv[]) {
         log_message("Output file written successfully: %s\n", output_fn);
     }
 
+    free(region_map);
+    free(region_stats);
+    free_run_length_map(region_runs);
+    free_foreground_mask(mask);
+    free(colors);
+    free_graph(graph);
+    free_bmp(image);
+    return 1;
+}
+
+// Потоковый режим: в памяти только несколько строк, отрезки меток сбрасываются во временный файл
+static int run_streaming(const Options* options, const char* input_fn, const char* output_fn,
+                         ColoringSummary* summary, Timer* coloring_timer) {
+    char spill_filename[512];
+    snprintf(spill_filename, sizeof(spill_filename), "%s.runs.tmp", output_fn);
+
+    log_message("\nSTEP -2: Region detection (streaming)\n");
+    log_message("=====================================\n");
+    printf("Streaming BMP file: %s\n", input_fn);
+    int region_count = 0;
+    RegionStats* region_stats = NULL;
+    StreamedRegions* regions = find_regions_streaming(input_fn, spill_filename, &region_count, &region_stats);
+    if (!regions) {
+        log_message("ERROR: Failed to detect regions\n");
+        return 0;
+    }
+    printf("Found %d regions.\n", region_count);
+    log_message("Region detection completed successfully\n");
+    log_message("Total regions found: %d\n", region_count);
+    log_message("Label runs spilled to %s: %ld runs\n", spill_filename, regions->num_runs);
+    log_region_stats(region_stats, region_count);
+
+    printf("Building adjacency graph...\n");
+    GraphOptions graph_options;
+    graph_options.kind = options->graph_kind;
+    graph_options.num_threads = 1;
+    graph_options.border_width = 1;
+    Graph* graph = build_adjacency_graph_streamed(regions, region_count, &graph_options);
+    if (!graph) {
+        log_message("ERROR: Failed to build adjacency graph\n");
+        free(region_stats);
+        free_streamed_regions(regions);
+        return 0;
+    }
+
+    printf("Coloring graph...\n");
+    int* colors = color_regions(options, graph, summary, coloring_timer);
+    if (!colors) {
+        log_message("ERROR: Failed to color graph\n");
+        free_graph(graph);
+        free(region_stats);
+        free_streamed_regions(regions);
+        return 0;
+    }
+
+    printf("Coloring complete.\n");
+
+    printf("Writing output file: %s\n", output_fn);
+    if (!write_colored_bmp_streamed(output_fn, regions, colors)) {
+        fprintf(stderr, "Failed to write BMP file.\n");
+        log_message("ERROR: Failed to write BMP file\n");
+    } else {
+        log_message("Output file written successfully: %s\n", output_fn);
+    }
+
+    free(colors);
+    free(region_stats);
+    free_graph(graph);
+    free_streamed_regions(regions);
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (argc < 3 || !parse_options(argc, argv, &options)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    const char* input_fn = argv[1];
+    const char* output_fn = argv[2];
+
+    int logging_disabled = should_disable_logging();
+
+    char log_filename[256] = {0};
+    if (!logging_disabled) {
+        snprintf(log_filename, sizeof(log_filename), "map_coloring_log_%s.txt", output_fn);
+        init_logging(log_filename);
+    }
+    
+    log_message("MAP COLORING PROCESS STARTED\n");
+    log_message("============================\n");
+    log_message("Input file: %s\n", input_fn);
+    log_message("Output file: %s\n", output_fn);
+    if (!logging_disabled) {
+        log_message("Log file: %s\n", log_filename);
+    }
+
+    Timer total_timer, coloring_timer;
+    start_timer(&total_timer);
+
+    ColoringSummary summary = {0, 0};
+    int ok = options.stream ? run_streaming(&options, input_fn, output_fn, &summary, &coloring_timer)
+                            : run_in_memory(&options, input_fn, output_fn, &summary, &coloring_timer);
+    if (!ok) {
+        close_logging();
+        return 1;
+    }
+
     stop_timer(&total_timer);
 
     log_message("\nFINAL STATISTICS\n");
     log_message("================\n");
-    log_message("Number of colors used: %d\n", num_colors);
+    log_message("Number of colors used: %d\n", summary.num_colors);
+    if (options.exact_time_budget > 0) {
+        log_message("Minimum number of colors: %s\n", summary.proven_optimal ? "proven" : "not proven");
+    }
     log_message("Coloring algorithm time: %.4f seconds\n", get_duration(&coloring_timer));
     log_message("Total execution time: %.4f seconds\n", get_duration(&total_timer));
     
     printf("\n--- Results ---\n");
-    printf("Number of colors used: %d\n", num_colors);
+    printf("Number of colors used: %d\n", summary.num_colors);
+    if (options.exact_time_budget > 0) {
+        printf("Minimum number of colors: %s\n", summary.proven_optimal ? "proven" : "not proven");
+    }
     printf("Coloring algorithm time: %.4f seconds\n", get_duration(&coloring_timer));
     printf("Total execution time: %.4f seconds\n", get_duration(&total_timer));
     if (!logging_disabled) {
@@ -126,11 +449,6 @@ int main(int argc, char* argv[]) {
     }
     printf("---------------\n");
 
-    free(region_map);
-    free(colors);
-    free_graph(graph);
-    free_bmp(image);
-    
     if (!logging_disabled) {
         close_logging();
     }
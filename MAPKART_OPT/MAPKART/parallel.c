@@ -0,0 +1,73 @@
+#include "parallel.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+typedef struct {
+    ParallelTask task;
+    void* context;
+    int num_tasks;
+    atomic_int next_task;
+} TaskQueue;
+
+static void* worker_main(void* arg) {
+    TaskQueue* queue = (TaskQueue*)arg;
+    for (;;) {
+        int task_index = atomic_fetch_add(&queue->next_task, 1);
+        if (task_index >= queue->num_tasks) break;
+        queue->task(queue->context, task_index);
+    }
+    return NULL;
+}
+
+void parallel_for(int num_tasks, int num_threads, ParallelTask task, void* context) {
+    if (num_tasks <= 0) return;
+    if (num_threads > num_tasks) num_threads = num_tasks;
+
+    TaskQueue queue;
+    queue.task = task;
+    queue.context = context;
+    queue.num_tasks = num_tasks;
+    atomic_init(&queue.next_task, 0);
+
+    // Оптимизация: без лишних потоков для одной задачи или одного потока
+    if (num_threads <= 1) {
+        worker_main(&queue);
+        return;
+    }
+
+    // Вызывающий поток тоже работает, поэтому создаём на один поток меньше
+    pthread_t* threads = (pthread_t*)malloc((num_threads - 1) * sizeof(pthread_t));
+    int started = 0;
+    if (threads) {
+        for (; started < num_threads - 1; started++) {
+            if (pthread_create(&threads[started], NULL, worker_main, &queue) != 0) {
+                break; // Оставшиеся задачи выполнят уже запущенные потоки
+            }
+        }
+    }
+
+    worker_main(&queue);
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+}
+
+int get_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int count = (int)info.dwNumberOfProcessors;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? count : 1;
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+// Задача для параллельного выполнения: task_index пробегает [0, num_tasks)
+typedef void (*ParallelTask)(void* context, int task_index);
+
+// Выполняет task(context, i) для всех i из [0, num_tasks) на num_threads потоках.
+// Потоки разбирают задачи из общего счётчика, поэтому задачи разного размера
+// распределяются равномерно. Возвращается после завершения всех задач.
+void parallel_for(int num_tasks, int num_threads, ParallelTask task, void* context);
+
+// Количество доступных процессорных ядер (не меньше 1)
+int get_cpu_count(void);
+
+#endif // PARALLEL_H
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include "parallel_coloring.h"
+#include "parallel.h"
+#include "colorizer.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define JP_CHUNK 1024 // Вершин раунда на одну задачу parallel_for
+
+// Перемешивание номера вершины (lowbias32): случайный, но воспроизводимый
+// порядок среди вершин одинаковой степени
+static inline uint32_t vertex_hash(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// Приоритет вершины: сначала степень (largest-first), затем хеш
+static inline uint64_t vertex_priority(const Graph* csr, int v) {
+    uint64_t degree = (uint64_t)(csr->offsets[v + 1] - csr->offsets[v]);
+    return (degree << 32) | vertex_hash((uint32_t)v);
+}
+
+// Строгий порядок: при совпадении хешей решает номер
+static inline int precedes(const Graph* csr, int u, int v) {
+    uint64_t pu = vertex_priority(csr, u);
+    uint64_t pv = vertex_priority(csr, v);
+    return pu > pv || (pu == pv && u < v);
+}
+
+typedef struct {
+    const Graph* csr;
+    unsigned all_colors;
+    int* colors;
+    atomic_int* pending;  // Нераскрашенные соседи с большим приоритетом
+    const int* frontier;  // Вершины текущего раунда
+    int frontier_size;
+    int* next;            // Вершины следующего раунда
+    atomic_int next_size;
+} JonesPlassmann;
+
+static void count_pending_task(void* context, int task_index) {
+    JonesPlassmann* jp = (JonesPlassmann*)context;
+    const Graph* csr = jp->csr;
+    int begin = 1 + task_index * JP_CHUNK;
+    int end = begin + JP_CHUNK < csr->num_vertices ? begin + JP_CHUNK : csr->num_vertices;
+    for (int v = begin; v < end; v++) {
+        int count = 0;
+        for (int k = csr->offsets[v]; k < csr->offsets[v + 1]; k++) {
+            count += precedes(csr, csr->neighbors[k], v);
+        }
+        atomic_init(&jp->pending[v], count);
+        if (count == 0) {
+            jp->next[atomic_fetch_add(&jp->next_size, 1)] = v;
+        }
+    }
+}
+
+// Все соседи вершины раунда либо раскрашены в прошлых раундах (больший
+// приоритет), либо ждут её и не красятся в этом раунде, поэтому чтение
+// их цветов не пересекается с записью
+static void color_round_task(void* context, int task_index) {
+    JonesPlassmann* jp = (JonesPlassmann*)context;
+    const Graph* csr = jp->csr;
+    int begin = task_index * JP_CHUNK;
+    int end = begin + JP_CHUNK < jp->frontier_size ? begin + JP_CHUNK : jp->frontier_size;
+    for (int i = begin; i < end; i++) {
+        int v = jp->frontier[i];
+        unsigned used = 0;
+        for (int k = csr->offsets[v]; k < csr->offsets[v + 1]; k++) {
+            int color = jp->colors[csr->neighbors[k]];
+            if (color) used |= 1u << (color - 1);
+        }
+        unsigned free_colors = ~used & jp->all_colors;
+        // Вершина без свободного цвета остаётся с 0 и всё равно отпускает соседей
+        jp->colors[v] = free_colors ? lowest_bit_index(free_colors) + 1 : 0;
+        for (int k = csr->offsets[v]; k < csr->offsets[v + 1]; k++) {
+            int u = csr->neighbors[k];
+            if (!precedes(csr, v, u)) continue;
+            if (atomic_fetch_sub(&jp->pending[u], 1) == 1) {
+                jp->next[atomic_fetch_add(&jp->next_size, 1)] = u;
+            }
+        }
+    }
+}
+
+int jones_plassmann_color(const Graph* csr, int max_colors, int num_threads,
+                          int* colors, int* uncolored, int* num_uncolored) {
+    int n = csr->num_vertices;
+    JonesPlassmann jp;
+    jp.csr = csr;
+    jp.all_colors = (1u << max_colors) - 1;
+    jp.colors = colors;
+    jp.pending = (atomic_int*)malloc(n * sizeof(atomic_int));
+    int* frontier = (int*)malloc(n * sizeof(int));
+    jp.next = (int*)malloc(n * sizeof(int));
+    if (!jp.pending || !frontier || !jp.next) {
+        fprintf(stderr, "Failed to allocate memory for parallel coloring.\n");
+        free(jp.pending);
+        free(frontier);
+        free(jp.next);
+        return -1;
+    }
+    for (int v = 0; v < n; v++) {
+        colors[v] = 0;
+    }
+    atomic_init(&jp.next_size, 0);
+    parallel_for((n - 1 + JP_CHUNK - 1) / JP_CHUNK, num_threads, count_pending_task, &jp);
+
+    int colored = 0;
+    int rounds = 0;
+    while (atomic_load(&jp.next_size) > 0) {
+        // Следующий раунд становится текущим
+        int* swap = frontier;
+        frontier = jp.next;
+        jp.next = swap;
+        jp.frontier = frontier;
+        jp.frontier_size = atomic_load(&jp.next_size);
+        atomic_store(&jp.next_size, 0);
+        parallel_for((jp.frontier_size + JP_CHUNK - 1) / JP_CHUNK, num_threads, color_round_task, &jp);
+        colored += jp.frontier_size;
+        rounds++;
+    }
+    log_message("Jones-Plassmann: %d vertices in %d rounds on %d threads\n", colored, rounds, num_threads);
+
+    int max_color = 0;
+    int uncolored_count = 0;
+    for (int v = 1; v < n; v++) {
+        if (colors[v] > max_color) max_color = colors[v];
+        if (colors[v] == 0) {
+            if (uncolored) uncolored[uncolored_count] = v;
+            uncolored_count++;
+        }
+    }
+    free(jp.pending);
+    free(frontier);
+    free(jp.next);
+    if (num_uncolored) *num_uncolored = uncolored_count;
+    return max_color;
+}
\ No newline at end of file
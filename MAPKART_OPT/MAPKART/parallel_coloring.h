@@ -0,0 +1,18 @@
+#ifndef PARALLEL_COLORING_H
+#define PARALLEL_COLORING_H
+
+#include "graph.h"
+
+// Параллельная раскраска Jones-Plassmann: у каждой вершины фиксированный
+// приоритет (степень, при равенстве - хеш номера), вершина красится в
+// наименьший свободный цвет, как только раскрашены все её соседи с большим
+// приоритетом. Раунд - независимое множество таких вершин, раскрашиваемое
+// параллельно (parallel_for); соседи с меньшим приоритетом, у которых не
+// осталось ожидаемых соседей, образуют следующий раунд. Результат не зависит
+// от числа потоков и порядка выполнения задач.
+// Параметры и результат - как у dsatur_color(); вершины без свободного цвета
+// перечисляются в uncolored по возрастанию номера.
+int jones_plassmann_color(const Graph* csr, int max_colors, int num_threads,
+                          int* colors, int* uncolored, int* num_uncolored);
+
+#endif // PARALLEL_COLORING_H
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "peeling.h"
+#include <stdio.h>
+#include "colorizer.h"
+
+PeeledGraph* peel_low_degree(const Graph* csr, int max_colors) {
+    int n = csr->num_vertices;
+    PeeledGraph* result = (PeeledGraph*)calloc(1, sizeof(PeeledGraph));
+    int* degree = (int*)malloc(n * sizeof(int));
+    unsigned char* state = (unsigned char*)calloc(n, 1); // 1 - в очереди на снятие, 2 - снята
+    int* core_index = (int*)malloc(n * sizeof(int));
+    if (result) {
+        result->peeled = (int*)malloc(n * sizeof(int));
+        result->core_vertices = (int*)malloc(n * sizeof(int));
+    }
+    if (!result || !degree || !state || !core_index || !result->peeled || !result->core_vertices) {
+        fprintf(stderr, "Failed to allocate memory for degree peeling.\n");
+        free(degree);
+        free(state);
+        free(core_index);
+        free_peeled_graph(result);
+        return NULL;
+    }
+
+    // Очередь на снятие хранится в самом массиве peeled: вершина попадает
+    // в конец, как только её степень становится меньше max_colors,
+    // и снимается, когда до неё доходит указатель head
+    int tail = 0;
+    for (int v = 1; v < n; v++) {
+        degree[v] = csr->offsets[v + 1] - csr->offsets[v];
+        if (degree[v] < max_colors) {
+            state[v] = 1;
+            result->peeled[tail++] = v;
+        }
+    }
+    for (int head = 0; head < tail; head++) {
+        int v = result->peeled[head];
+        state[v] = 2;
+        for (int k = csr->offsets[v]; k < csr->offsets[v + 1]; k++) {
+            int u = csr->neighbors[k];
+            if (state[u]) continue;
+            if (--degree[u] < max_colors) {
+                state[u] = 1;
+                result->peeled[tail++] = u;
+            }
+        }
+    }
+    result->num_peeled = tail;
+
+    // Ядро: оставшиеся вершины в порядке возрастания номеров, поэтому
+    // рёбра в новой нумерации сразу упорядочены
+    int core_count = 0;
+    for (int v = 1; v < n; v++) {
+        if (state[v]) continue;
+        core_count++;
+        core_index[v] = core_count;
+        result->core_vertices[core_count] = v;
+    }
+    result->core_vertices[0] = 0;
+    int num_edges = 0;
+    for (int v = 1; v < n; v++) {
+        if (state[v]) continue;
+        for (int k = csr->offsets[v]; k < csr->offsets[v + 1]; k++) {
+            int u = csr->neighbors[k];
+            if (u > v && !state[u]) num_edges++;
+        }
+    }
+    Edge* edges = (Edge*)malloc((num_edges + 1) * sizeof(Edge));
+    if (edges) {
+        int e = 0;
+        for (int v = 1; v < n; v++) {
+            if (state[v]) continue;
+            for (int k = csr->offsets[v]; k < csr->offsets[v + 1]; k++) {
+                int u = csr->neighbors[k];
+                if (u > v && !state[u]) {
+                    edges[e].u = core_index[v];
+                    edges[e].v = core_index[u];
+                    e++;
+                }
+            }
+        }
+        result->core = create_graph_from_edges(core_count + 1, edges, num_edges, GRAPH_CSR);
+    }
+    free(edges);
+    free(degree);
+    free(state);
+    free(core_index);
+    if (!result->core) {
+        fprintf(stderr, "Failed to allocate memory for degree peeling.\n");
+        free_peeled_graph(result);
+        return NULL;
+    }
+    log_message("Degree peeling: %d of %d vertices peeled, core has %d vertices and %d edges\n",
+                result->num_peeled, n - 1, core_count, num_edges);
+    return result;
+}
+
+int color_peeled_vertices(const Graph* csr, const PeeledGraph* peeled, int max_colors, int* colors) {
+    const unsigned all_colors = (1u << max_colors) - 1;
+    int max_color = 0;
+    // Соседи, снятые раньше вершины, ещё не раскрашены (цвет 0), а раскрашенных
+    // меньше max_colors, поэтому свободный цвет всегда есть
+    for (int i = peeled->num_peeled - 1; i >= 0; i--) {
+        int v = peeled->peeled[i];
+        unsigned used = 0;
+        for (int k = csr->offsets[v]; k < csr->offsets[v + 1]; k++) {
+            int color = colors[csr->neighbors[k]];
+            if (color) used |= 1u << (color - 1);
+        }
+        int color = lowest_bit_index(~used & all_colors) + 1;
+        colors[v] = color;
+        if (color > max_color) max_color = color;
+    }
+    return max_color;
+}
+
+void free_peeled_graph(PeeledGraph* peeled) {
+    if (peeled) {
+        free_graph(peeled->core);
+        free(peeled->core_vertices);
+        free(peeled->peeled);
+        free(peeled);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#ifndef PEELING_H
+#define PEELING_H
+
+#include "graph.h"
+
+// Ядро графа для раскраски в max_colors цветов: вершины степени меньше
+// max_colors снимаются по одной (степень соседей при этом уменьшается),
+// пока такие есть. Снятую вершину всегда можно раскрасить последней:
+// при снятии у неё меньше max_colors оставшихся соседей.
+typedef struct {
+    Graph* core;        // CSR-подграф оставшихся вершин в номерах 1 .. k (вершина 0 - фиктивная)
+    int* core_vertices; // core_vertices[i] - номер вершины ядра i в исходном графе
+    int* peeled;        // Снятые вершины в порядке снятия
+    int num_peeled;
+} PeeledGraph;
+
+// csr - граф в виде CSR. Возвращает NULL при нехватке памяти.
+PeeledGraph* peel_low_degree(const Graph* csr, int max_colors);
+// Раскрашивает снятые вершины в обратном порядке наименьшим свободным цветом,
+// когда вершины ядра в colors уже раскрашены. Возвращает наибольший цвет.
+int color_peeled_vertices(const Graph* csr, const PeeledGraph* peeled, int max_colors, int* colors);
+void free_peeled_graph(PeeledGraph* peeled);
+
+#endif // PEELING_H
\ No newline at end of file
@@ -1,42 +1,112 @@
 #include "region_detector.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "parallel.h"
 
-// Оптимизированная проверка, является ли пиксель белым
-// Inline для устранения накладных расходов на вызов
-static inline int is_white(Pixel p) {
-    // Оптимизация: проверяем все каналы > 250 (почти белый)
-    // Используем логическое И с short-circuit evaluation
-    return p.r > 250 && p.g > 250 && p.b > 250;
+// Отрезок строки [x_left, x_right] в строке y, соседи которого ещё не просмотрены
+typedef struct {
+    int x_left;
+    int x_right;
+    int y;
+} Span;
+
+// Явный стек отрезков в куче вместо рекурсии.
+// Один стек переиспользуется для всех регионов изображения.
+typedef struct {
+    Span* items;
+    int size;
+    int capacity;
+} SpanStack;
+
+static int span_stack_push(SpanStack* stack, int x_left, int x_right, int y) {
+    if (stack->size == stack->capacity) {
+        int new_capacity = stack->capacity ? stack->capacity * 2 : 256;
+        Span* items = (Span*)realloc(stack->items, new_capacity * sizeof(Span));
+        if (!items) {
+            return 0;
+        }
+        stack->items = items;
+        stack->capacity = new_capacity;
+    }
+    Span* span = &stack->items[stack->size++];
+    span->x_left = x_left;
+    span->x_right = x_right;
+    span->y = y;
+    return 1;
 }
 
-void flood_fill(int x, int y, int width, int height, Pixel* data, int* region_map, int current_region_id) {
-    // Оптимизация: проверка границ в начале функции
-    if (x < 0 || x >= width || y < 0 || y >= height) return;
+// Белый пиксель строки, ещё не отнесённый к региону.
+// Цвет пикселя берётся из заранее построенной битовой маски.
+static inline int is_fillable(int x, const uint64_t* mask_words, const int* row) {
+    // Оптимизация: проверяем сначала region_map (быстрее), потом маску
+    return row[x] == 0 && ((mask_words[x >> 6] >> (x & 63)) & 1);
+}
 
-    int index = y * width + x;
-    // Оптимизация: проверяем сначала region_map (быстрее), потом is_white
-    if (region_map[index] != 0 || !is_white(data[index])) return;
+// Итеративная построчная заливка (scanline flood fill).
+// Каждый пиксель помечается ровно один раз, а глубина обработки не зависит
+// от размера региона: вместо кадра стека на пиксель храним отрезки строк.
+// Заодно каждый залитый отрезок добавляется в сводку региона stats.
+// Возвращает 0, если не удалось расширить стек.
+static int scanline_fill(int x, int y, int width, int height, const ForegroundMask* mask,
+                         int* region_map, int current_region_id, SpanStack* stack, RegionStats* stats) {
+    stack->size = 0;
+    if (!span_stack_push(stack, x, x, y)) {
+        return 0;
+    }
 
-    region_map[index] = current_region_id;
+    while (stack->size > 0) {
+        Span span = stack->items[--stack->size];
+        int* row = region_map + span.y * width; // Снижение мощности
+        const uint64_t* mask_words = mask_row(mask, span.y);
+        int cx = span.x_left;
 
-    // Оптимизация: порядок вызовов для лучшей локальности данных
-    // Сначала горизонтальные (лучшая кэш-локальность), потом вертикальные
-    flood_fill(x + 1, y, width, height, data, region_map, current_region_id);
-    flood_fill(x - 1, y, width, height, data, region_map, current_region_id);
-    flood_fill(x, y + 1, width, height, data, region_map, current_region_id);
-    flood_fill(x, y - 1, width, height, data, region_map, current_region_id);
-}
+        while (cx <= span.x_right) {
+            if (!is_fillable(cx, mask_words, row)) {
+                cx++;
+                continue;
+            }
 
-int* find_regions(BMPImage* image, int* region_count) {
-    int width = image->info_header.width;
-    int height = image->info_header.height;
-    int* region_map = (int*)calloc(width * height, sizeof(int));
+            // Расширяем отрезок влево и вправо до границы региона
+            int left = cx;
+            while (left > 0 && is_fillable(left - 1, mask_words, row)) {
+                left--;
+            }
+            int right = cx;
+            while (right < width - 1 && is_fillable(right + 1, mask_words, row)) {
+                right++;
+            }
 
-    if (!region_map) {
-        fprintf(stderr, "Failed to allocate memory for region map.\n");
-        return NULL;
+            for (int i = left; i <= right; i++) {
+                row[i] = current_region_id;
+            }
+            add_run_to_stats(stats, left, right + 1, span.y, width,
+                             span.y > 0 ? mask_row(mask, span.y - 1) : NULL, mask_words,
+                             span.y < height - 1 ? mask_row(mask, span.y + 1) : NULL);
+
+            if (span.y > 0 && !span_stack_push(stack, left, right, span.y - 1)) {
+                return 0;
+            }
+            if (span.y < height - 1 && !span_stack_push(stack, left, right, span.y + 1)) {
+                return 0;
+            }
+
+            // Пиксель right + 1 заведомо не подходит
+            cx = right + 2;
+        }
     }
+    return 1;
+}
+
+// Разметка заливкой: для каждого ещё не помеченного белого пикселя
+// заливается весь его регион. Сводки регионов возвращаются в *stats_out.
+// Если border не NULL, в том же проходе по строкам заполняется индекс границы.
+// Возвращает число регионов или -1 при ошибке.
+static int label_scanline(const ForegroundMask* mask, int* region_map, BorderIndex* border,
+                          RegionStats** stats_out) {
+    int width = mask->width;
+    int height = mask->height;
 
     int current_region_id = 1;
     long total_pixels = (long)width * height;
@@ -44,15 +114,45 @@ int* find_regions(BMPImage* image, int* region_count) {
 
     // Оптимизация: предвычисление width для избежания повторных умножений
     const int width_const = width;
-    Pixel* data = image->data; // Кэшируем указатель
+    SpanStack stack = {NULL, 0, 0};
+    RegionStats* stats = NULL;
+    int stats_capacity = 0;
+    BorderRunList border_runs = {NULL, 0, 0};
     
     for (int y = 0; y < height; y++) {
-        int y_offset = y * width_const; // Индуктивная переменная
+        int* row = region_map + y * width_const; // Индуктивная переменная
+        const uint64_t* mask_words = mask_row(mask, y);
+        if (border && !collect_border_runs(border, mask, y, &border_runs)) {
+            fprintf(stderr, "\nFailed to allocate memory for border index.\n");
+            free(stack.items);
+            free(stats);
+            free_border_run_list(&border_runs);
+            return -1;
+        }
         for (int x = 0; x < width; x++) {
-            int index = y_offset + x;
-            // Оптимизация: проверяем сначала region_map (быстрее), потом is_white
-            if (region_map[index] == 0 && is_white(data[index])) {
-                flood_fill(x, y, width_const, height, data, region_map, current_region_id);
+            if (is_fillable(x, mask_words, row)) {
+                if (current_region_id >= stats_capacity) {
+                    int new_capacity = stats_capacity ? stats_capacity * 2 : 1024;
+                    RegionStats* grown = (RegionStats*)realloc(stats, new_capacity * sizeof(RegionStats));
+                    if (!grown) {
+                        fprintf(stderr, "\nFailed to allocate memory for region statistics.\n");
+                        free(stack.items);
+                        free(stats);
+                        free_border_run_list(&border_runs);
+                        return -1;
+                    }
+                    stats = grown;
+                    stats_capacity = new_capacity;
+                }
+                reset_region_stats(&stats[current_region_id]);
+                if (!scanline_fill(x, y, width_const, height, mask, region_map, current_region_id, &stack,
+                                   &stats[current_region_id])) {
+                    fprintf(stderr, "\nFailed to allocate memory for flood fill stack.\n");
+                    free(stack.items);
+                    free(stats);
+                    free_border_run_list(&border_runs);
+                    return -1;
+                }
                 current_region_id++;
             }
 
@@ -65,10 +165,788 @@ int* find_regions(BMPImage* image, int* region_count) {
             }
         }
     }
-    printf("\nRegion detection complete. Total regions: %d\n", current_region_id);
-    printf("\nRegion detection complete.\n");
+    free(stack.items);
+    if (border && !finish_border_index(border, &border_runs, 1)) {
+        free(stats);
+        return -1;
+    }
+    if (!stats) {
+        stats = (RegionStats*)malloc(sizeof(RegionStats)); // Только нулевой элемент
+        if (!stats) return -1;
+    }
+    reset_region_stats(&stats[0]);
+    *stats_out = stats;
+    return current_region_id - 1;
+}
+
+// Таблица эквивалентности меток для двухпроходной разметки.
+// Метка 0 зарезервирована под границу, временные метки начинаются с 1.
+// Для каждой временной метки копится сводка её пикселей.
+typedef struct {
+    int* parent;
+    unsigned char* rank;
+    RegionStats* stats;
+    int size;
+    int capacity;
+} UnionFind;
+
+static int uf_make_set(UnionFind* uf) {
+    if (uf->size == uf->capacity) {
+        int new_capacity = uf->capacity ? uf->capacity * 2 : 1024;
+        int* parent = (int*)realloc(uf->parent, new_capacity * sizeof(int));
+        if (!parent) {
+            return -1;
+        }
+        uf->parent = parent;
+        unsigned char* rank = (unsigned char*)realloc(uf->rank, new_capacity);
+        if (!rank) {
+            return -1;
+        }
+        uf->rank = rank;
+        RegionStats* stats = (RegionStats*)realloc(uf->stats, new_capacity * sizeof(RegionStats));
+        if (!stats) {
+            return -1;
+        }
+        uf->stats = stats;
+        uf->capacity = new_capacity;
+    }
+    int label = uf->size++;
+    uf->parent[label] = label;
+    uf->rank[label] = 0;
+    reset_region_stats(&uf->stats[label]);
+    return label;
+}
+
+// Поиск корня со сжатием пути (path halving)
+static inline int uf_find(UnionFind* uf, int label) {
+    int* parent = uf->parent;
+    while (parent[label] != label) {
+        parent[label] = parent[parent[label]];
+        label = parent[label];
+    }
+    return label;
+}
+
+// Объединение по рангу
+static inline void uf_union(UnionFind* uf, int a, int b) {
+    int root_a = uf_find(uf, a);
+    int root_b = uf_find(uf, b);
+    if (root_a == root_b) return;
+
+    if (uf->rank[root_a] < uf->rank[root_b]) {
+        uf->parent[root_a] = root_b;
+    } else if (uf->rank[root_a] > uf->rank[root_b]) {
+        uf->parent[root_b] = root_a;
+    } else {
+        uf->parent[root_b] = root_a;
+        uf->rank[root_a]++;
+    }
+}
+
+static void uf_free(UnionFind* uf) {
+    free(uf->parent);
+    free(uf->rank);
+    free(uf->stats);
+}
+
+// Итоговые номера регионов для временных меток 1 .. uf->size - 1.
+// Временные метки выдаются в порядке обхода, поэтому наименьшая метка
+// компоненты принадлежит её первому пикселю: проходя метки по возрастанию,
+// получаем номера в порядке первого появления региона.
+// Сводки временных меток собираются в *stats_out по итоговым номерам.
+// Возвращает массив (final[метка] = номер региона) или NULL.
+static int* resolve_labels(UnionFind* uf, int* region_count, RegionStats** stats_out) {
+    int* final_label = (int*)calloc(uf->size, sizeof(int));
+    if (!final_label) return NULL;
+
+    int next_region_id = 1;
+    for (int label = 1; label < uf->size; label++) {
+        int root = uf_find(uf, label);
+        if (final_label[root] == 0) {
+            final_label[root] = next_region_id++;
+        }
+        final_label[label] = final_label[root];
+    }
+
+    // Регионов не больше, чем временных меток
+    RegionStats* stats = (RegionStats*)malloc(next_region_id * sizeof(RegionStats));
+    if (!stats) {
+        free(final_label);
+        return NULL;
+    }
+    for (int i = 0; i < next_region_id; i++) {
+        reset_region_stats(&stats[i]);
+    }
+    for (int label = 1; label < uf->size; label++) {
+        merge_region_stats(&stats[final_label[label]], &uf->stats[label]);
+    }
+    *stats_out = stats;
+    *region_count = next_region_id - 1;
+    return final_label;
+}
+
+
+
+// Двухпроходная разметка связных компонент (4-связность) для строк [y_begin, y_end).
+// Первый проход назначает временные метки по соседям сверху и слева
+// и записывает их эквивалентность в union-find, второй проход заменяет
+// временные метки итоговыми. Оба прохода идут по памяти строго
+// последовательно. Итоговые номера выдаются в порядке первого появления
+// региона при обходе, поэтому совпадают с номерами заливки.
+// Строки выше y_begin не просматриваются. Сводки регионов (по номерам
+// внутри полосы) возвращаются в *stats_out. Если border не NULL, отрезки
+// границы строк полосы собираются в border_runs по ходу первого прохода.
+// Возвращает число регионов или -1.
+static int label_rows(const ForegroundMask* mask, int* region_map, int y_begin, int y_end,
+                      int report_progress, BorderIndex* border, BorderRunList* border_runs,
+                      RegionStats** stats_out) {
+    int width = mask->width;
+    int height = mask->height;
+    UnionFind uf = {NULL, NULL, NULL, 0, 0};
+    if (uf_make_set(&uf) < 0) { // Метка 0 - граница
+        uf_free(&uf);
+        return -1;
+    }
+
+    // Проход 1: временные метки
+    int last_progress = -1;
+    for (int y = y_begin; y < y_end; y++) {
+        int* row = region_map + y * width; // Индуктивная переменная
+        int* up_row = y > y_begin ? row - width : NULL;
+        const uint64_t* mask_words = mask_row(mask, y);
+        for (int x = 0; x < width; x++) {
+            uint64_t word = mask_words[x >> 6];
+            if (word == 0) {
+                x |= 63; // Оптимизация: 64 пикселя границы подряд
+                continue;
+            }
+            if (!((word >> (x & 63)) & 1)) {
+                continue; // region_map уже обнулён calloc
+            }
+            int left = x > 0 ? row[x - 1] : 0;
+            int up = up_row ? up_row[x] : 0;
+
+            if (left && up) {
+                row[x] = left;
+                if (left != up) {
+                    uf_union(&uf, left, up);
+                }
+            } else if (left || up) {
+                row[x] = left | up; // Одна из меток равна 0
+            } else {
+                int label = uf_make_set(&uf);
+                if (label < 0) {
+                    uf_free(&uf);
+                    return -1;
+                }
+                row[x] = label;
+            }
+        }
+
+        // Внутри отрезка белых пикселей метка берётся у левого соседа,
+        // поэтому весь отрезок попадает в сводку метки его первого пикселя
+        const uint64_t* up_words = y > 0 ? mask_row(mask, y - 1) : NULL;
+        const uint64_t* down_words = y < height - 1 ? mask_row(mask, y + 1) : NULL;
+        for (int x = row_next_set(mask_words, 0, width); x < width; ) {
+            int end = row_next_clear(mask_words, x, width);
+            add_run_to_stats(&uf.stats[row[x]], x, end, y, width, up_words, mask_words, down_words);
+            x = row_next_set(mask_words, end, width);
+        }
+        // Маски строк y - 1 .. y + 1 только что прочитаны - отрезки границы берутся из кэша
+        if (border && !collect_border_runs(border, mask, y, border_runs)) {
+            uf_free(&uf);
+            return -1;
+        }
+
+        // Оптимизация: печатаем прогресс только при изменении процента
+        if (report_progress) {
+            int progress = (int)(100.0 * (y + 1 - y_begin) / (y_end - y_begin));
+            if (progress != last_progress) {
+                printf("\rFinding regions... %d%%", progress);
+                fflush(stdout);
+                last_progress = progress;
+            }
+        }
+    }
+
+    // Проход 2: итоговые плотные номера в порядке первого появления
+    int num_regions = 0;
+    int* final_label = resolve_labels(&uf, &num_regions, stats_out);
+    uf_free(&uf);
+    if (!final_label) {
+        return -1;
+    }
+
+    int* begin = region_map + y_begin * width;
+    int* end = region_map + y_end * width;
+    for (int* p = begin; p < end; p++) {
+        *p = final_label[*p]; // final_label[0] == 0
+    }
+
+    free(final_label);
+    return num_regions;
+}
+
+// Параллельная разметка горизонтальными полосами.
+//
+// 1. Каждая полоса размечается независимо (label_rows), метки полосы b
+//    становятся глобальными метками base[b] + 1 .. base[b] + count[b].
+// 2. Метки на стыках соседних полос объединяются в общем lock-free
+//    union-find: корнем всегда становится меньшая метка.
+// 3. Корни нумеруются по возрастанию глобальной метки.
+//
+// Глобальные метки возрастают в порядке первого появления региона
+// при обходе изображения, поэтому корень компоненты - метка её первого
+// пикселя, а итоговые номера совпадают с однопоточной разметкой
+// независимо от числа потоков.
+typedef struct {
+    const ForegroundMask* mask;
+    int* region_map;
+    int width;
+    int height;
+    int num_bands;
+    int* band_count;   // Число регионов в полосе
+    int* band_base;    // Смещение глобальных меток полосы
+    atomic_int* parent; // Общий union-find по глобальным меткам
+    int* final_label;  // Итоговый номер для каждой глобальной метки
+    RegionStats** band_stats; // Сводки регионов полосы по номерам внутри полосы
+    BorderIndex* border;      // Если не NULL - индекс границы, отрезки собираются по полосам
+    BorderRunList* border_runs;
+    atomic_int failed;
+} BandLabeling;
+
+static inline int band_begin(const BandLabeling* ctx, int band) {
+    return (int)((long)ctx->height * band / ctx->num_bands);
+}
+
+static int atomic_uf_find(atomic_int* parent, int label) {
+    for (;;) {
+        int p = atomic_load_explicit(&parent[label], memory_order_relaxed);
+        if (p == label) return label;
+        int grandparent = atomic_load_explicit(&parent[p], memory_order_relaxed);
+        // Сжатие пути безопасно: grandparent всегда предок label
+        if (grandparent != p) {
+            atomic_compare_exchange_weak_explicit(&parent[label], &p, grandparent,
+                                                  memory_order_relaxed, memory_order_relaxed);
+        }
+        label = grandparent;
+    }
+}
+
+static void atomic_uf_union(atomic_int* parent, int a, int b) {
+    for (;;) {
+        a = atomic_uf_find(parent, a);
+        b = atomic_uf_find(parent, b);
+        if (a == b) return;
+        if (a > b) {
+            int tmp = a;
+            a = b;
+            b = tmp;
+        }
+        // Подвешиваем больший корень к меньшему; при гонке повторяем
+        int expected = b;
+        if (atomic_compare_exchange_strong(&parent[b], &expected, a)) return;
+    }
+}
+
+static void band_label_task(void* context, int band) {
+    BandLabeling* ctx = (BandLabeling*)context;
+    int count = label_rows(ctx->mask, ctx->region_map, band_begin(ctx, band), band_begin(ctx, band + 1), 0,
+                           ctx->border, ctx->border ? &ctx->border_runs[band] : NULL, &ctx->band_stats[band]);
+    if (count < 0) {
+        atomic_store(&ctx->failed, 1);
+        count = 0;
+    }
+    ctx->band_count[band] = count;
+}
+
+static void band_merge_task(void* context, int band) {
+    BandLabeling* ctx = (BandLabeling*)context;
+    if (band == 0) return;
+
+    int width = ctx->width;
+    int y = band_begin(ctx, band);
+    int* row = ctx->region_map + y * width;
+    int* up_row = row - width;
+    int base = ctx->band_base[band];
+    int up_base = ctx->band_base[band - 1];
+
+    for (int x = 0; x < width; x++) {
+        // Оптимизация: соседние пиксели стыка почти всегда дают ту же пару
+        if (row[x] && up_row[x] && !(x > 0 && row[x] == row[x - 1] && up_row[x] == up_row[x - 1])) {
+            atomic_uf_union(ctx->parent, up_base + up_row[x], base + row[x]);
+        }
+    }
+}
+
+static void band_resolve_task(void* context, int band) {
+    BandLabeling* ctx = (BandLabeling*)context;
+    int first = ctx->band_base[band] + 1;
+    int last = ctx->band_base[band] + ctx->band_count[band];
+    for (int label = first; label <= last; label++) {
+        int root = atomic_uf_find(ctx->parent, label);
+        // Корень не больше метки, поэтому его номер уже известен
+        if (root != label) {
+            ctx->final_label[label] = ctx->final_label[root];
+        }
+    }
+}
+
+static void band_relabel_task(void* context, int band) {
+    BandLabeling* ctx = (BandLabeling*)context;
+    int base = ctx->band_base[band];
+    int* begin = ctx->region_map + band_begin(ctx, band) * ctx->width;
+    int* end = ctx->region_map + band_begin(ctx, band + 1) * ctx->width;
+    int* final_label = ctx->final_label;
+    for (int* p = begin; p < end; p++) {
+        if (*p) {
+            *p = final_label[base + *p];
+        }
+    }
+}
+
+static int label_two_pass_parallel(const ForegroundMask* mask, int* region_map, int num_threads,
+                                   BorderIndex* border, RegionStats** stats_out) {
+    BandLabeling ctx;
+    ctx.mask = mask;
+    ctx.region_map = region_map;
+    ctx.width = mask->width;
+    ctx.height = mask->height;
+    ctx.num_bands = num_threads < ctx.height ? num_threads : ctx.height;
+    ctx.band_count = (int*)calloc(ctx.num_bands, sizeof(int));
+    ctx.band_base = (int*)calloc(ctx.num_bands + 1, sizeof(int));
+    ctx.band_stats = (RegionStats**)calloc(ctx.num_bands, sizeof(RegionStats*));
+    ctx.border = border;
+    ctx.border_runs = border ? (BorderRunList*)calloc(ctx.num_bands, sizeof(BorderRunList)) : NULL;
+    ctx.parent = NULL;
+    ctx.final_label = NULL;
+    atomic_init(&ctx.failed, 0);
+
+    int result = -1;
+    if (!ctx.band_count || !ctx.band_base || !ctx.band_stats || (border && !ctx.border_runs)) goto cleanup;
+
+    printf("\rFinding regions in %d bands...", ctx.num_bands);
+    fflush(stdout);
+
+    parallel_for(ctx.num_bands, num_threads, band_label_task, &ctx);
+    if (atomic_load(&ctx.failed)) goto cleanup;
+    if (border) {
+        int ok = finish_border_index(border, ctx.border_runs, ctx.num_bands);
+        free(ctx.border_runs);
+        ctx.border_runs = NULL;
+        if (!ok) goto cleanup;
+    }
+
+    for (int b = 0; b < ctx.num_bands; b++) {
+        ctx.band_base[b + 1] = ctx.band_base[b] + ctx.band_count[b];
+    }
+    int total_labels = ctx.band_base[ctx.num_bands];
+
+    ctx.parent = (atomic_int*)malloc((total_labels + 1) * sizeof(atomic_int));
+    ctx.final_label = (int*)calloc(total_labels + 1, sizeof(int));
+    if (!ctx.parent || !ctx.final_label) goto cleanup;
+    for (int label = 0; label <= total_labels; label++) {
+        atomic_init(&ctx.parent[label], label);
+    }
+
+    parallel_for(ctx.num_bands, num_threads, band_merge_task, &ctx);
+
+    // Нумеруем корни по возрастанию метки: полосы по порядку, внутри полосы по метке
+    int next_region_id = 1;
+    for (int b = 0; b < ctx.num_bands; b++) {
+        int first = ctx.band_base[b] + 1;
+        int last = ctx.band_base[b] + ctx.band_count[b];
+        for (int label = first; label <= last; label++) {
+            if (atomic_load_explicit(&ctx.parent[label], memory_order_relaxed) == label) {
+                ctx.final_label[label] = next_region_id++;
+            }
+        }
+    }
+
+    parallel_for(ctx.num_bands, num_threads, band_resolve_task, &ctx);
+    parallel_for(ctx.num_bands, num_threads, band_relabel_task, &ctx);
+
+    // Части регионов, разрезанных границами полос, сводятся вместе
+    RegionStats* stats = (RegionStats*)malloc(next_region_id * sizeof(RegionStats));
+    if (!stats) goto cleanup;
+    for (int i = 0; i < next_region_id; i++) {
+        reset_region_stats(&stats[i]);
+    }
+    for (int b = 0; b < ctx.num_bands; b++) {
+        for (int local = 1; local <= ctx.band_count[b]; local++) {
+            merge_region_stats(&stats[ctx.final_label[ctx.band_base[b] + local]], &ctx.band_stats[b][local]);
+        }
+    }
+    *stats_out = stats;
+    result = next_region_id - 1;
+
+cleanup:
+    if (ctx.band_stats) {
+        for (int b = 0; b < ctx.num_bands; b++) {
+            free(ctx.band_stats[b]);
+        }
+    }
+    free(ctx.band_stats);
+    if (ctx.border_runs) {
+        for (int b = 0; b < ctx.num_bands; b++) {
+            free_border_run_list(&ctx.border_runs[b]);
+        }
+    }
+    free(ctx.border_runs);
+    free(ctx.band_count);
+    free(ctx.band_base);
+    free(ctx.parent);
+    free(ctx.final_label);
+    return result;
+}
+
+static int label_two_pass(const ForegroundMask* mask, int* region_map, int num_threads,
+                          BorderIndex* border, RegionStats** stats_out) {
+    int count;
+    if (num_threads > 1 && mask->height > 1) {
+        count = label_two_pass_parallel(mask, region_map, num_threads, border, stats_out);
+    } else {
+        BorderRunList border_runs = {NULL, 0, 0};
+        count = label_rows(mask, region_map, 0, mask->height, 1, border, &border_runs, stats_out);
+        if (count >= 0 && border && !finish_border_index(border, &border_runs, 1)) {
+            free(*stats_out);
+            *stats_out = NULL;
+            count = -1;
+        }
+        free_border_run_list(&border_runs);
+    }
+    if (count < 0) {
+        fprintf(stderr, "\nFailed to allocate memory for label equivalence table.\n");
+    }
+    return count;
+}
+
+// Сводки регионов отдаются вызывающему через *region_stats (если не NULL)
+static void publish_region_stats(RegionStats* stats, int num_regions, RegionStats** region_stats) {
+    finish_region_stats(stats, num_regions);
+    if (region_stats) {
+        *region_stats = stats;
+    } else {
+        free(stats);
+    }
+}
+
+int* find_regions(const ForegroundMask* mask, int* region_count, const LabelingOptions* options,
+                  RegionStats** region_stats, BorderIndex** border_index) {
+    int width = mask->width;
+    int height = mask->height;
+    int* region_map = (int*)calloc(width * height, sizeof(int));
+
+    if (!region_map) {
+        fprintf(stderr, "Failed to allocate memory for region map.\n");
+        return NULL;
+    }
+
+    // Индекс границы заполняется самой разметкой, отдельного прохода по маске нет
+    BorderIndex* border = NULL;
+    if (border_index) {
+        border = create_border_index(width, height);
+        if (!border) {
+            free(region_map);
+            return NULL;
+        }
+    }
+
+    int count;
+    RegionStats* stats = NULL;
+    if (options->engine == LABELING_TWO_PASS) {
+        count = label_two_pass(mask, region_map, options->num_threads, border, &stats);
+    } else {
+        count = label_scanline(mask, region_map, border, &stats);
+    }
+    if (count < 0) {
+        free_border_index(border);
+        free(stats);
+        free(region_map);
+        return NULL;
+    }
+    if (border_index) {
+        *border_index = border;
+    }
 
+    printf("\nRegion detection complete. Total regions: %d\n", count + 1);
+    printf("\nRegion detection complete.\n");
 
-    *region_count = current_region_id - 1;
+    publish_region_stats(stats, count, region_stats);
+    *region_count = count;
     return region_map;
+}
+
+// Размечает отрезки белых пикселей строки (mask_words) по отрезкам строки
+// выше: отрезок, пересекающийся с отрезками сверху, 4-связен с ними и получает
+// их метку, а различные метки сверху объединяются в union-find. Отрезок без
+// соседей сверху получает новую метку. runs должен вмещать (width + 1) / 2
+// отрезков. Возвращает число отрезков строки или -1 при нехватке памяти.
+static int label_row_runs(UnionFind* uf, const uint64_t* mask_words, int width,
+                          const LabelRun* up_runs, int up_count, LabelRun* runs) {
+    int count = 0;
+    int up = 0;
+    int x = row_next_set(mask_words, 0, width);
+    while (x < width) {
+        int end = row_next_clear(mask_words, x, width);
+
+        // Пропускаем отрезки сверху, закончившиеся левее текущего
+        while (up < up_count && up_runs[up].start + up_runs[up].length <= x) {
+            up++;
+        }
+        int label = 0;
+        for (int k = up; k < up_count && up_runs[k].start < end; k++) {
+            if (label == 0) {
+                label = up_runs[k].label;
+            } else if (up_runs[k].label != label) {
+                uf_union(uf, label, up_runs[k].label);
+            }
+        }
+        if (label == 0) {
+            label = uf_make_set(uf);
+            if (label < 0) return -1;
+        }
+        runs[count].start = x;
+        runs[count].length = end - x;
+        runs[count].label = label;
+        count++;
+
+        x = row_next_set(mask_words, end, width);
+    }
+    return count;
+}
+
+// Добавляет размеченные отрезки строки y в сводки их временных меток
+static void add_row_runs_to_stats(UnionFind* uf, const LabelRun* runs, int count, int y, int width,
+                                  const uint64_t* up, const uint64_t* cur, const uint64_t* down) {
+    for (int i = 0; i < count; i++) {
+        add_run_to_stats(&uf->stats[runs[i].label], runs[i].start, runs[i].start + runs[i].length,
+                         y, width, up, cur, down);
+    }
+}
+
+static void print_progress(int y, int height, int* last_progress) {
+    int progress = (int)(100.0 * (y + 1) / height);
+    if (progress != *last_progress) {
+        printf("\rFinding regions... %d%%", progress);
+        fflush(stdout);
+        *last_progress = progress;
+    }
+}
+
+RunLengthMap* find_regions_rle(const ForegroundMask* mask, int* region_count, RegionStats** region_stats) {
+    int width = mask->width;
+    int height = mask->height;
+    int max_row_runs = (width + 1) / 2;
+
+    RunLengthMap* rle = create_run_length_map(width, height);
+    UnionFind uf = {NULL, NULL, NULL, 0, 0};
+    int* final_label = NULL;
+    if (!rle || uf_make_set(&uf) < 0) { // Метка 0 - граница
+        goto fail;
+    }
+
+    // Проход 1: временные метки отрезков
+    int last_progress = -1;
+    for (int y = 0; y < height; y++) {
+        LabelRun* runs = rle_reserve(rle, max_row_runs);
+        if (!runs) goto fail;
+        const LabelRun* up_runs = y > 0 ? rle->runs + rle->row_start[y - 1] : NULL;
+        int up_count = y > 0 ? rle->row_start[y] - rle->row_start[y - 1] : 0;
+
+        int count = label_row_runs(&uf, mask_row(mask, y), width, up_runs, up_count, runs);
+        if (count < 0) goto fail;
+        add_row_runs_to_stats(&uf, runs, count, y, width,
+                              y > 0 ? mask_row(mask, y - 1) : NULL, mask_row(mask, y),
+                              y < height - 1 ? mask_row(mask, y + 1) : NULL);
+        rle_finish_row(rle, y, count);
+        print_progress(y, height, &last_progress);
+    }
+
+    // Проход 2: итоговые плотные номера в порядке первого появления
+    int num_regions = 0;
+    RegionStats* stats = NULL;
+    final_label = resolve_labels(&uf, &num_regions, &stats);
+    if (!final_label) goto fail;
+    for (int i = 0; i < rle->num_runs; i++) {
+        rle->runs[i].label = final_label[rle->runs[i].label];
+    }
+
+    free(final_label);
+    uf_free(&uf);
+
+    printf("\nRegion detection complete. Total regions: %d (%d runs)\n", num_regions, rle->num_runs);
+
+    publish_region_stats(stats, num_regions, region_stats);
+    *region_count = num_regions;
+    return rle;
+
+fail:
+    fprintf(stderr, "\nFailed to allocate memory for run-length label map.\n");
+    free(final_label);
+    uf_free(&uf);
+    free_run_length_map(rle);
+    return NULL;
+}
+
+StreamedRegions* find_regions_streaming(const char* filename, const char* spill_filename, int* region_count,
+                                        RegionStats** region_stats) {
+    BMPStream* input = bmp_open_read(filename);
+    if (!input) return NULL;
+
+    StreamedRegions* regions = (StreamedRegions*)calloc(1, sizeof(StreamedRegions));
+    int width = input->info_header.width;
+    int height = input->info_header.height;
+    int max_row_runs = (width + 1) / 2;
+    int words_per_row = (width + 63) / 64;
+
+    Pixel* pixels = (Pixel*)malloc(width * sizeof(Pixel));
+    // Маски трёх последних строк: строка y лежит в слоте y % 3
+    uint64_t* mask_words = (uint64_t*)malloc(3 * words_per_row * sizeof(uint64_t));
+    LabelRun* up_runs = (LabelRun*)malloc(max_row_runs * sizeof(LabelRun));
+    LabelRun* runs = (LabelRun*)malloc(max_row_runs * sizeof(LabelRun));
+    UnionFind uf = {NULL, NULL, NULL, 0, 0};
+    int up_count = 0;
+
+    if (!regions || !pixels || !mask_words || !up_runs || !runs || uf_make_set(&uf) < 0) {
+        fprintf(stderr, "Failed to allocate memory for streaming labeling.\n");
+        goto fail;
+    }
+    regions->header = input->header;
+    regions->info_header = input->info_header;
+    regions->width = width;
+    regions->height = height;
+    regions->row_runs = up_runs; // Освобождается вместе с regions
+
+    if (spill_filename) {
+        // Без копии имени файл не удалить при освобождении, поэтому не создаём его
+        regions->spill_filename = (char*)malloc(strlen(spill_filename) + 1);
+        if (!regions->spill_filename) {
+            fprintf(stderr, "Failed to allocate memory for streaming labeling.\n");
+            goto fail;
+        }
+        strcpy(regions->spill_filename, spill_filename);
+        regions->spill = fopen(spill_filename, "w+b");
+    } else {
+        regions->spill = tmpfile();
+    }
+    if (!regions->spill) {
+        perror("Failed to create spill file");
+        goto fail;
+    }
+
+    // Проход 1: строки читаются по одной, отрезки получают временные метки
+    // и сразу сбрасываются в файл. Сводка строки y - 1 дополняется, когда
+    // прочитана строка y: для пикселей у границы нужна строка снизу.
+    int last_progress = -1;
+    for (int y = 0; y < height; y++) {
+        if (!bmp_read_row(input, pixels)) {
+            fprintf(stderr, "\nError: Unexpected end of BMP file at row %d.\n", y);
+            goto fail;
+        }
+        uint64_t* cur_words = mask_words + (y % 3) * words_per_row;
+        classify_row(pixels, width, cur_words);
+
+        if (y > 0) {
+            add_row_runs_to_stats(&uf, up_runs, up_count, y - 1, width,
+                                  y > 1 ? mask_words + ((y + 1) % 3) * words_per_row : NULL,
+                                  mask_words + ((y + 2) % 3) * words_per_row, cur_words);
+        }
+
+        int count = label_row_runs(&uf, cur_words, width, up_runs, up_count, runs);
+        if (count < 0) {
+            fprintf(stderr, "\nFailed to allocate memory for label equivalence table.\n");
+            goto fail;
+        }
+        if (fwrite(&count, sizeof(int), 1, regions->spill) != 1 ||
+            fwrite(runs, sizeof(LabelRun), count, regions->spill) != (size_t)count) {
+            fprintf(stderr, "\nFailed to write spill file.\n");
+            goto fail;
+        }
+        regions->num_runs += count;
+
+        // Текущая строка становится строкой сверху для следующей
+        LabelRun* tmp = up_runs;
+        up_runs = runs;
+        runs = tmp;
+        up_count = count;
+        print_progress(y, height, &last_progress);
+    }
+    if (height > 0) {
+        add_row_runs_to_stats(&uf, up_runs, up_count, height - 1, width,
+                              height > 1 ? mask_words + ((height + 1) % 3) * words_per_row : NULL,
+                              mask_words + ((height - 1) % 3) * words_per_row, NULL);
+    }
+    regions->row_runs = up_runs;
+
+    // Проход 2 не нужен: итоговые номера применяются при чтении строк из файла
+    int num_regions = 0;
+    RegionStats* stats = NULL;
+    regions->final_label = resolve_labels(&uf, &num_regions, &stats);
+    if (!regions->final_label) {
+        fprintf(stderr, "\nFailed to allocate memory for label equivalence table.\n");
+        goto fail;
+    }
+    printf("\nRegion detection complete. Total regions: %d (%ld runs, %d provisional labels)\n",
+           num_regions, regions->num_runs, uf.size - 1);
+    publish_region_stats(stats, num_regions, region_stats);
+
+    uf_free(&uf);
+    free(runs);
+    free(pixels);
+    free(mask_words);
+    bmp_close(input);
+    regions->next_row = 0;
+    *region_count = num_regions;
+    return regions;
+
+fail:
+    if (regions) regions->row_runs = NULL;
+    free_streamed_regions(regions);
+    uf_free(&uf);
+    free(up_runs);
+    free(runs);
+    free(pixels);
+    free(mask_words);
+    bmp_close(input);
+    return NULL;
+}
+
+int streamed_read_row(StreamedRegions* regions, int y, const LabelRun** runs) {
+    if (y == 0) {
+        rewind(regions->spill);
+        regions->next_row = 0;
+    }
+    if (y != regions->next_row) {
+        return -1; // Только последовательное чтение
+    }
+
+    int count;
+    if (fread(&count, sizeof(int), 1, regions->spill) != 1 ||
+        count < 0 || count > (regions->width + 1) / 2 ||
+        fread(regions->row_runs, sizeof(LabelRun), count, regions->spill) != (size_t)count) {
+        fprintf(stderr, "Failed to read spill file at row %d.\n", y);
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        regions->row_runs[i].label = regions->final_label[regions->row_runs[i].label];
+    }
+    regions->next_row++;
+    *runs = regions->row_runs;
+    return count;
+}
+
+void free_streamed_regions(StreamedRegions* regions) {
+    if (regions) {
+        if (regions->spill) {
+            fclose(regions->spill);
+            if (regions->spill_filename) {
+                remove(regions->spill_filename);
+            }
+        }
+        free(regions->spill_filename);
+        free(regions->final_label);
+        free(regions->row_runs);
+        free(regions);
+    }
 }
\ No newline at end of file
@@ -2,7 +2,59 @@
 #define REGION_DETECTOR_H
 
 #include "bmp_handler.h"
+#include "foreground_mask.h"
+#include "run_length_map.h"
+#include "region_stats.h"
+#include "border_index.h"
 
-int* find_regions(BMPImage* image, int* region_count);
+// Алгоритм поиска регионов
+typedef enum {
+    LABELING_SCANLINE = 0, // Построчная заливка каждого региона
+    LABELING_TWO_PASS      // Двухпроходная разметка с union-find
+} LabelingEngine;
+
+typedef struct {
+    LabelingEngine engine;
+    int num_threads; // Для LABELING_TWO_PASS: > 1 - разметка полосами в нескольких потоках
+} LabelingOptions;
+
+// Размечает связные белые области маски. Белые пиксели берутся из mask,
+// построенной build_foreground_mask(), поэтому само изображение не читается.
+// Если region_stats не NULL, туда возвращается массив сводок регионов
+// (индекс - номер региона, region_count + 1 элементов), собранный в том же проходе.
+// Если border_index не NULL, туда возвращается индекс пикселей границы для
+// построения графа, собранный в тех же проходах по строкам.
+int* find_regions(const ForegroundMask* mask, int* region_count, const LabelingOptions* options,
+                  RegionStats** region_stats, BorderIndex** border_index);
+
+// Размечает регионы сразу в виде отрезков строк, без массива int на пиксель.
+// Номера регионов совпадают с find_regions().
+RunLengthMap* find_regions_rle(const ForegroundMask* mask, int* region_count, RegionStats** region_stats);
+
+// Результат потоковой разметки: отрезки строк лежат во временном файле,
+// в памяти остаются только таблица номеров регионов и буфер одной строки
+typedef struct {
+    FILE* spill;
+    char* spill_filename; // NULL, если использован tmpfile()
+    BMPHeader header;
+    BMPInfoHeader info_header;
+    int width;
+    int height;
+    long num_runs;
+    int* final_label;     // Временная метка -> номер региона
+    LabelRun* row_runs;   // Буфер строки для streamed_read_row
+    int next_row;
+} StreamedRegions;
+
+// Размечает BMP-файл построчно, не загружая изображение целиком: в памяти
+// хранятся две строки отрезков и растущая таблица эквивалентности меток.
+// Отрезки каждой строки сбрасываются в spill_filename (или tmpfile(), если NULL).
+// Номера регионов совпадают с find_regions().
+StreamedRegions* find_regions_streaming(const char* filename, const char* spill_filename, int* region_count,
+                                        RegionStats** region_stats);
+// Читает отрезки строки y с итоговыми номерами регионов. Строки читаются
+// по порядку; y == 0 начинает чтение сначала. Возвращает число отрезков или -1.
+int streamed_read_row(StreamedRegions* regions, int y, const LabelRun** runs);
+void free_streamed_regions(StreamedRegions* regions);
 
 #endif // REGION_DETECTOR_H
\ No newline at end of file
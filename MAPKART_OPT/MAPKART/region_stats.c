@@ -0,0 +1,84 @@
+#include "region_stats.h"
+#include <limits.h>
+#include "colorizer.h"
+
+void reset_region_stats(RegionStats* stats) {
+    stats->area = 0;
+    stats->min_x = INT_MAX;
+    stats->min_y = INT_MAX;
+    stats->max_x = -1;
+    stats->max_y = -1;
+    stats->centroid_x = 0.0;
+    stats->centroid_y = 0.0;
+    stats->border_pixels = 0;
+}
+
+// Число белых пикселей в [x_begin, x_end), у которых есть сосед-граница.
+// Соседи за краем изображения границей не считаются.
+static long count_border_contacts(int x_begin, int x_end, int width,
+                                  const uint64_t* up, const uint64_t* cur, const uint64_t* down) {
+    const int words_per_row = (width + 63) >> 6;
+    long count = 0;
+    for (int w = x_begin >> 6; w <= (x_end - 1) >> 6; w++) {
+        uint64_t c = cur[w];
+        // Оптимизация: соседи слева и справа для 64 пикселей сразу сдвигом слова
+        uint64_t left = (c << 1) | (w > 0 ? cur[w - 1] >> 63 : 1);
+        uint64_t right = (c >> 1) | (w + 1 < words_per_row ? cur[w + 1] << 63 : 0);
+        if (w == (width - 1) >> 6) {
+            right |= (uint64_t)1 << ((width - 1) & 63);
+        }
+        uint64_t inner = c & left & right;
+        if (up) inner &= up[w];
+        if (down) inner &= down[w];
+        uint64_t contact = c & ~inner;
+        if (w == x_begin >> 6) contact &= ~(uint64_t)0 << (x_begin & 63);
+        if (w == (x_end - 1) >> 6) contact &= row_valid_bits(x_end, w);
+        count += bit_count(contact);
+    }
+    return count;
+}
+
+void add_run_to_stats(RegionStats* stats, int x_begin, int x_end, int y, int width,
+                      const uint64_t* up, const uint64_t* cur, const uint64_t* down) {
+    long length = x_end - x_begin;
+    stats->area += length;
+    if (x_begin < stats->min_x) stats->min_x = x_begin;
+    if (x_end - 1 > stats->max_x) stats->max_x = x_end - 1;
+    if (y < stats->min_y) stats->min_y = y;
+    if (y > stats->max_y) stats->max_y = y;
+    // Сумма арифметической прогрессии x_begin .. x_end - 1
+    stats->centroid_x += 0.5 * (double)(x_begin + x_end - 1) * length;
+    stats->centroid_y += (double)y * length;
+    stats->border_pixels += count_border_contacts(x_begin, x_end, width, up, cur, down);
+}
+
+void merge_region_stats(RegionStats* dst, const RegionStats* src) {
+    if (src->area == 0) return;
+    dst->area += src->area;
+    if (src->min_x < dst->min_x) dst->min_x = src->min_x;
+    if (src->min_y < dst->min_y) dst->min_y = src->min_y;
+    if (src->max_x > dst->max_x) dst->max_x = src->max_x;
+    if (src->max_y > dst->max_y) dst->max_y = src->max_y;
+    dst->centroid_x += src->centroid_x;
+    dst->centroid_y += src->centroid_y;
+    dst->border_pixels += src->border_pixels;
+}
+
+void finish_region_stats(RegionStats* stats, int num_regions) {
+    for (int i = 1; i <= num_regions; i++) {
+        if (stats[i].area > 0) {
+            stats[i].centroid_x /= stats[i].area;
+            stats[i].centroid_y /= stats[i].area;
+        }
+    }
+}
+
+void log_region_stats(const RegionStats* stats, int num_regions) {
+    log_message("\nRegion statistics:\n");
+    for (int i = 1; i <= num_regions; i++) {
+        const RegionStats* s = &stats[i];
+        log_message("  Region %d: %ld pixels, %ld border pixels, bbox (%d,%d)-(%d,%d), centroid (%.1f,%.1f)\n",
+                    i, s->area, s->border_pixels, s->min_x, s->min_y, s->max_x, s->max_y,
+                    s->centroid_x, s->centroid_y);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef REGION_STATS_H
+#define REGION_STATS_H
+
+#include "foreground_mask.h"
+
+// Сводка по одному региону, собираемая при разметке.
+// Пока регион размечается, centroid_x/centroid_y хранят суммы координат
+// пикселей; finish_region_stats() превращает их в центр масс.
+typedef struct {
+    long area;          // Число пикселей
+    int min_x;          // Ограничивающий прямоугольник (включительно)
+    int min_y;
+    int max_x;
+    int max_y;
+    double centroid_x;
+    double centroid_y;
+    long border_pixels; // Пиксели, у которых хотя бы один 4-сосед - граница
+} RegionStats;
+
+// Пустая сводка (регион без пикселей)
+void reset_region_stats(RegionStats* stats);
+
+// Добавляет к сводке отрезок [x_begin, x_end) строки y.
+// up/cur/down - битовые маски белых пикселей строк y - 1, y, y + 1
+// (NULL за краем изображения); по ним считаются пиксели у границы.
+void add_run_to_stats(RegionStats* stats, int x_begin, int x_end, int y, int width,
+                      const uint64_t* up, const uint64_t* cur, const uint64_t* down);
+
+// Добавляет к dst сводку src (части одного региона)
+void merge_region_stats(RegionStats* dst, const RegionStats* src);
+
+// Переводит суммы координат в центры масс для регионов 1 .. num_regions
+void finish_region_stats(RegionStats* stats, int num_regions);
+
+// Записывает сводку по регионам в лог
+void log_region_stats(const RegionStats* stats, int num_regions);
+
+#endif // REGION_STATS_H
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "row_transitions.h"
+#include <pthread.h>
+#include <string.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define ROW_TRANSITIONS_X86 1
+#include <immintrin.h>
+#endif
+
+static int use_avx2 = 0;
+static pthread_once_t transitions_init_once = PTHREAD_ONCE_INIT;
+
+static void init_transitions(void) {
+#ifdef ROW_TRANSITIONS_X86
+    use_avx2 = __builtin_cpu_supports("avx2");
+#endif
+}
+
+#ifdef ROW_TRANSITIONS_X86
+// SSE2: 4 метки за итерацию. Горизонтальное сравнение читает cur[x + 4],
+// поэтому векторный цикл останавливается до последнего пикселя строки.
+// Возвращает число обработанных пикселей.
+static int transitions_sse2(const int* cur, const int* next, int width,
+                            uint64_t* horizontal, uint64_t* vertical) {
+    int x = 0;
+    for (; x + 4 < width; x += 4) {
+        __m128i here = _mm_loadu_si128((const __m128i*)(cur + x));
+        __m128i right = _mm_loadu_si128((const __m128i*)(cur + x + 1));
+        uint64_t same = (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(here, right)));
+        horizontal[x >> 6] |= (~same & 0xF) << (x & 63);
+        if (next) {
+            __m128i below = _mm_loadu_si128((const __m128i*)(next + x));
+            same = (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(here, below)));
+            vertical[x >> 6] |= (~same & 0xF) << (x & 63);
+        }
+    }
+    return x;
+}
+
+__attribute__((target("avx2")))
+static int transitions_avx2(const int* cur, const int* next, int width,
+                            uint64_t* horizontal, uint64_t* vertical) {
+    int x = 0;
+    // AVX2: 8 меток за итерацию
+    for (; x + 8 < width; x += 8) {
+        __m256i here = _mm256_loadu_si256((const __m256i*)(cur + x));
+        __m256i right = _mm256_loadu_si256((const __m256i*)(cur + x + 1));
+        uint64_t same = (uint64_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(here, right)));
+        horizontal[x >> 6] |= (~same & 0xFF) << (x & 63);
+        if (next) {
+            __m256i below = _mm256_loadu_si256((const __m256i*)(next + x));
+            same = (uint64_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(here, below)));
+            vertical[x >> 6] |= (~same & 0xFF) << (x & 63);
+        }
+    }
+    // Хвост короче 8 меток добираем через SSE2
+    for (; x + 4 < width; x += 4) {
+        __m128i here = _mm_loadu_si128((const __m128i*)(cur + x));
+        __m128i right = _mm_loadu_si128((const __m128i*)(cur + x + 1));
+        uint64_t same = (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(here, right)));
+        horizontal[x >> 6] |= (~same & 0xF) << (x & 63);
+        if (next) {
+            __m128i below = _mm_loadu_si128((const __m128i*)(next + x));
+            same = (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(here, below)));
+            vertical[x >> 6] |= (~same & 0xF) << (x & 63);
+        }
+    }
+    return x;
+}
+#endif
+
+void find_row_transitions(const int* cur, const int* next, int width,
+                          uint64_t* horizontal, uint64_t* vertical) {
+    pthread_once(&transitions_init_once, init_transitions);
+    size_t words_size = ((width + 63) / 64) * sizeof(uint64_t);
+    memset(horizontal, 0, words_size);
+    memset(vertical, 0, words_size);
+
+    int x = 0;
+#ifdef ROW_TRANSITIONS_X86
+    if (use_avx2) {
+        x = transitions_avx2(cur, next, width, horizontal, vertical);
+    } else {
+        x = transitions_sse2(cur, next, width, horizontal, vertical);
+    }
+#endif
+    // Скалярный вариант: хвост строки или платформа без SIMD
+    for (; x < width; x++) {
+        if (x < width - 1 && cur[x] != cur[x + 1]) {
+            horizontal[x >> 6] |= (uint64_t)1 << (x & 63);
+        }
+        if (next && cur[x] != next[x]) {
+            vertical[x >> 6] |= (uint64_t)1 << (x & 63);
+        }
+    }
+}
\ No newline at end of file
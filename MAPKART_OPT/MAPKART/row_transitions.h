@@ -0,0 +1,15 @@
+#ifndef ROW_TRANSITIONS_H
+#define ROW_TRANSITIONS_H
+
+#include <stdint.h>
+
+// Битовые маски переходов меток в плотной карте регионов.
+// Маски строки занимают (width + 63) / 64 слов, как строка ForegroundMask:
+// horizontal - бит x установлен, если cur[x] != cur[x + 1] (для x < width - 1),
+// vertical   - бит x установлен, если cur[x] != next[x] (next == NULL - нет строки ниже).
+// Сравнение идёт сразу по 8 (AVX2) или 4 (SSE2) меткам, поэтому построитель графа
+// проходит только по позициям, где метка меняется, а не по всем пикселям строки.
+void find_row_transitions(const int* cur, const int* next, int width,
+                          uint64_t* horizontal, uint64_t* vertical);
+
+#endif // ROW_TRANSITIONS_H
\ No newline at end of file
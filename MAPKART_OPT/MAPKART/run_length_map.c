@@ -0,0 +1,71 @@
+#include "run_length_map.h"
+#include <stdlib.h>
+#include <string.h>
+
+RunLengthMap* create_run_length_map(int width, int height) {
+    RunLengthMap* rle = (RunLengthMap*)malloc(sizeof(RunLengthMap));
+    if (!rle) return NULL;
+    rle->width = width;
+    rle->height = height;
+    rle->row_start = (int*)calloc(height + 1, sizeof(int));
+    rle->runs = NULL;
+    rle->num_runs = 0;
+    rle->capacity = 0;
+    if (!rle->row_start) {
+        free(rle);
+        return NULL;
+    }
+    return rle;
+}
+
+void free_run_length_map(RunLengthMap* rle) {
+    if (rle) {
+        free(rle->row_start);
+        free(rle->runs);
+        free(rle);
+    }
+}
+
+LabelRun* rle_reserve(RunLengthMap* rle, int count) {
+    if (rle->num_runs + count > rle->capacity) {
+        int new_capacity = rle->capacity ? rle->capacity : 4096;
+        while (new_capacity < rle->num_runs + count) {
+            new_capacity *= 2;
+        }
+        LabelRun* runs = (LabelRun*)realloc(rle->runs, new_capacity * sizeof(LabelRun));
+        if (!runs) return NULL;
+        rle->runs = runs;
+        rle->capacity = new_capacity;
+    }
+    return rle->runs + rle->num_runs;
+}
+
+void decode_runs(const LabelRun* runs, int count, int width, int* labels, uint64_t* words) {
+    if (labels) memset(labels, 0, width * sizeof(int));
+    if (words) memset(words, 0, ((width + 63) / 64) * sizeof(uint64_t));
+
+    for (int i = 0; i < count; i++) {
+        const LabelRun* run = &runs[i];
+        int end = run->start + run->length;
+        if (labels) {
+            for (int x = run->start; x < end; x++) {
+                labels[x] = run->label;
+            }
+        }
+        if (words) {
+            // Оптимизация: заполняем биты отрезка словами, а не по одному
+            for (int x = run->start; x < end; ) {
+                int bit = x & 63;
+                int n = end - x < 64 - bit ? end - x : 64 - bit;
+                uint64_t bits = n == 64 ? ~(uint64_t)0 : (((uint64_t)1 << n) - 1);
+                words[x >> 6] |= bits << bit;
+                x += n;
+            }
+        }
+    }
+}
+
+void rle_decode_row(const RunLengthMap* rle, int y, int* labels, uint64_t* words) {
+    int first = rle->row_start[y];
+    decode_runs(rle->runs + first, rle->row_start[y + 1] - first, rle->width, labels, words);
+}
\ No newline at end of file
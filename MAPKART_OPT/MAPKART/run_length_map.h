@@ -0,0 +1,43 @@
+#ifndef RUN_LENGTH_MAP_H
+#define RUN_LENGTH_MAP_H
+
+#include <stdint.h>
+
+// Отрезок строки из пикселей одного региона: [start, start + length)
+typedef struct {
+    int start;
+    int length;
+    int label;
+} LabelRun;
+
+// Карта регионов в виде отрезков (RLE). Хранятся только отрезки регионов,
+// промежутки между ними - граница (номер 0). Отрезки строки y занимают
+// runs[row_start[y]] .. runs[row_start[y + 1] - 1] и упорядочены по start.
+typedef struct {
+    int width;
+    int height;
+    int* row_start; // height + 1 элементов
+    LabelRun* runs;
+    int num_runs;
+    int capacity;
+} RunLengthMap;
+
+RunLengthMap* create_run_length_map(int width, int height);
+void free_run_length_map(RunLengthMap* rle);
+// Гарантирует место под count новых отрезков после runs[num_runs - 1].
+// Возвращает указатель на первое свободное место или NULL при нехватке памяти.
+LabelRun* rle_reserve(RunLengthMap* rle, int count);
+// Завершает строку y, в которую записано count отрезков после rle_reserve()
+static inline void rle_finish_row(RunLengthMap* rle, int y, int count) {
+    rle->num_runs += count;
+    rle->row_start[y + 1] = rle->num_runs;
+}
+
+// Разворачивает count отрезков строки ширины width в номера регионов и/или
+// битовую маску белых пикселей ((width + 63) / 64 слов). Любой выход может быть NULL.
+void decode_runs(const LabelRun* runs, int count, int width, int* labels, uint64_t* words);
+
+// Разворачивает строку y карты (см. decode_runs)
+void rle_decode_row(const RunLengthMap* rle, int y, int* labels, uint64_t* words);
+
+#endif // RUN_LENGTH_MAP_H
\ No newline at end of file
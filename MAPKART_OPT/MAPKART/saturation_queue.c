@@ -0,0 +1,30 @@
+#include "saturation_queue.h"
+#include <stdlib.h>
+
+int saturation_queue_init(SaturationQueue* queue, int num_vertices, int max_degree) {
+    queue->max_degree = max_degree;
+    queue->head = (int*)malloc((size_t)SATURATION_LEVELS * (max_degree + 1) * sizeof(int));
+    queue->next = (int*)malloc(num_vertices * sizeof(int));
+    queue->prev = (int*)malloc(num_vertices * sizeof(int));
+    if (!queue->head || !queue->next || !queue->prev) {
+        saturation_queue_free(queue);
+        return 0;
+    }
+    for (int i = 0; i < SATURATION_LEVELS * (max_degree + 1); i++) {
+        queue->head[i] = -1;
+    }
+    for (int s = 0; s < SATURATION_LEVELS; s++) {
+        queue->top[s] = 0;
+        queue->count[s] = 0;
+    }
+    return 1;
+}
+
+void saturation_queue_free(SaturationQueue* queue) {
+    free(queue->head);
+    free(queue->next);
+    free(queue->prev);
+    queue->head = NULL;
+    queue->next = NULL;
+    queue->prev = NULL;
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef SATURATION_QUEUE_H
+#define SATURATION_QUEUE_H
+
+#define SATURATION_LEVELS 5 // Насыщенность 0 .. 4
+
+// Корзины вершин по ключу (насыщенность, степень) для DSATUR: для каждой
+// насыщенности - двусвязные списки по степени. top[s] - не меньше наибольшей
+// степени непустой корзины уровня s (поднимается при вставке, опускается при
+// поиске), count[s] - вершин на уровне. Вставка и удаление - O(1).
+typedef struct {
+    int max_degree;
+    int* head;  // SATURATION_LEVELS * (max_degree + 1)
+    int* next;
+    int* prev;
+    int top[SATURATION_LEVELS];
+    int count[SATURATION_LEVELS];
+} SaturationQueue;
+
+// Пустая очередь для вершин 0 .. num_vertices - 1. Возвращает 0 при нехватке памяти.
+int saturation_queue_init(SaturationQueue* queue, int num_vertices, int max_degree);
+void saturation_queue_free(SaturationQueue* queue);
+
+static inline int* saturation_bucket(SaturationQueue* queue, int saturation, int degree) {
+    return &queue->head[saturation * (queue->max_degree + 1) + degree];
+}
+
+// Вставка в начало корзины: при равных ключах первой выходит вставленная последней
+static inline void saturation_queue_insert(SaturationQueue* queue, int vertex, int saturation, int degree) {
+    int* head = saturation_bucket(queue, saturation, degree);
+    queue->prev[vertex] = -1;
+    queue->next[vertex] = *head;
+    if (*head >= 0) queue->prev[*head] = vertex;
+    *head = vertex;
+    queue->count[saturation]++;
+    if (degree > queue->top[saturation]) queue->top[saturation] = degree;
+}
+
+static inline void saturation_queue_remove(SaturationQueue* queue, int vertex, int saturation, int degree) {
+    if (queue->prev[vertex] >= 0) {
+        queue->next[queue->prev[vertex]] = queue->next[vertex];
+    } else {
+        *saturation_bucket(queue, saturation, degree) = queue->next[vertex];
+    }
+    if (queue->next[vertex] >= 0) queue->prev[queue->next[vertex]] = queue->prev[vertex];
+    queue->count[saturation]--;
+}
+
+// Вершина с наибольшей насыщенностью, а среди них - с наибольшей степенью,
+// без удаления из очереди; -1, если очередь пуста. Указатель top опускается
+// только при поиске, поэтому просматриваются лишь корзины между ним и
+// наибольшей занятой степенью.
+static inline int saturation_queue_peek_max(SaturationQueue* queue) {
+    for (int s = SATURATION_LEVELS - 1; s >= 0; s--) {
+        if (queue->count[s] == 0) continue;
+        while (*saturation_bucket(queue, s, queue->top[s]) < 0) {
+            queue->top[s]--;
+        }
+        return *saturation_bucket(queue, s, queue->top[s]);
+    }
+    return -1;
+}
+
+#endif // SATURATION_QUEUE_H
\ No newline at end of file
@@ -1,13 +1,23 @@
 #include "utils.h"
 
+static double current_time(void) {
+#if defined(CLOCK_MONOTONIC) && !defined(_WIN32)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
 void start_timer(Timer* timer) {
-    timer->start = clock();
+    timer->start = current_time();
 }
 
 void stop_timer(Timer* timer) {
-    timer->end = clock();
+    timer->end = current_time();
 }
 
 double get_duration(Timer* timer) {
-    return ((double)(timer->end - timer->start)) / CLOCKS_PER_SEC;
+    return timer->end - timer->start;
 }
\ No newline at end of file
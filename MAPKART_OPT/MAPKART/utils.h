@@ -3,10 +3,11 @@
 
 #include <time.h>
 
-// Структура для хранения времени выполнения
+// Структура для хранения времени выполнения (секунды реального времени).
+// Реальное, а не процессорное время: clock() суммирует время всех потоков.
 typedef struct {
-    clock_t start;
-    clock_t end;
+    double start;
+    double end;
 } Timer;
 
 void start_timer(Timer* timer);
@@ -0,0 +1,209 @@
+#include "vertex_order.h"
+#include <stdio.h>
+#include <string.h>
+#include "colorizer.h"
+#include "edge_buffer.h"
+
+static inline int csr_degree(const Graph* csr, int v) {
+    return csr->offsets[v + 1] - csr->offsets[v];
+}
+
+// Псевдопериферийная вершина компоненты start (George-Liu): обход в ширину,
+// переход к вершине наименьшей степени последнего уровня, пока растёт
+// число уровней. level - рабочий массив, все элементы равны -1 до и после вызова.
+static int peripheral_vertex(const Graph* csr, int start, int* level, int* queue) {
+    int best_depth = -1;
+    for (int attempt = 0; attempt < 4; attempt++) {
+        int head = 0;
+        int tail = 0;
+        level[start] = 0;
+        queue[tail++] = start;
+        while (head < tail) {
+            int v = queue[head++];
+            for (int k = csr->offsets[v]; k < csr->offsets[v + 1]; k++) {
+                int u = csr->neighbors[k];
+                if (level[u] < 0) {
+                    level[u] = level[v] + 1;
+                    queue[tail++] = u;
+                }
+            }
+        }
+        int depth = level[queue[tail - 1]];
+        int candidate = queue[tail - 1];
+        for (int i = tail - 1; i >= 0 && level[queue[i]] == depth; i--) {
+            if (csr_degree(csr, queue[i]) < csr_degree(csr, candidate)) candidate = queue[i];
+        }
+        for (int i = 0; i < tail; i++) {
+            level[queue[i]] = -1;
+        }
+        if (depth <= best_depth) break;
+        best_depth = depth;
+        start = candidate;
+    }
+    return start;
+}
+
+// Порядок обхода в ширину (order[0] = 0). Компоненты обходятся по очереди:
+// для BFS - от вершины с меньшим номером, для RCM - от псевдопериферийной
+// вершины (поиск начинается с вершины наименьшей степени), а соседи
+// добавляются по возрастанию степени; затем порядок RCM переворачивается.
+// Все шаги линейны: стартовые вершины RCM упорядочены сортировкой подсчётом
+// по степени, поиск периферийной вершины - несколько обходов компоненты.
+static int bfs_order(const Graph* csr, VertexOrder order_kind, int* order) {
+    int n = csr->num_vertices;
+    int rcm = order_kind == VERTEX_ORDER_RCM;
+    char* visited = (char*)calloc(n, 1);
+    int* starts = (int*)malloc(n * sizeof(int));
+    int max_degree = 0;
+    for (int v = 1; v < n; v++) {
+        if (csr_degree(csr, v) > max_degree) max_degree = csr_degree(csr, v);
+    }
+    int* degree_start = rcm ? (int*)calloc(max_degree + 2, sizeof(int)) : NULL;
+    int* level = rcm ? (int*)malloc(n * sizeof(int)) : NULL;
+    int* queue = rcm ? (int*)malloc(n * sizeof(int)) : NULL;
+    if (!visited || !starts || (rcm && (!degree_start || !level || !queue))) {
+        free(visited);
+        free(starts);
+        free(degree_start);
+        free(level);
+        free(queue);
+        return 0;
+    }
+    if (rcm) {
+        memset(level, -1, n * sizeof(int));
+    }
+
+    // Кандидаты в начало компоненты
+    if (rcm) {
+        for (int v = 1; v < n; v++) {
+            degree_start[csr_degree(csr, v) + 1]++;
+        }
+        for (int d = 0; d <= max_degree; d++) {
+            degree_start[d + 1] += degree_start[d];
+        }
+        for (int v = 1; v < n; v++) {
+            starts[degree_start[csr_degree(csr, v)]++] = v;
+        }
+    } else {
+        for (int v = 1; v < n; v++) {
+            starts[v - 1] = v;
+        }
+    }
+
+    visited[0] = 1;
+    order[0] = 0;
+    int head = 1;
+    int tail = 1;
+    for (int s = 0; s < n - 1; s++) {
+        int start = starts[s];
+        if (visited[start]) continue;
+        if (rcm) {
+            start = peripheral_vertex(csr, start, level, queue);
+        }
+        visited[start] = 1;
+        order[tail++] = start;
+        while (head < tail) {
+            int v = order[head++];
+            int first_new = tail;
+            for (int k = csr->offsets[v]; k < csr->offsets[v + 1]; k++) {
+                int u = csr->neighbors[k];
+                if (!visited[u]) {
+                    visited[u] = 1;
+                    order[tail++] = u;
+                }
+            }
+            if (rcm) {
+                // Новых соседей немного (карта почти планарна) - сортировка вставками
+                for (int i = first_new + 1; i < tail; i++) {
+                    int u = order[i];
+                    int j = i - 1;
+                    while (j >= first_new && csr_degree(csr, order[j]) > csr_degree(csr, u)) {
+                        order[j + 1] = order[j];
+                        j--;
+                    }
+                    order[j + 1] = u;
+                }
+            }
+        }
+    }
+    if (rcm) {
+        for (int i = 1, j = n - 1; i < j; i++, j--) {
+            int t = order[i];
+            order[i] = order[j];
+            order[j] = t;
+        }
+    }
+    free(visited);
+    free(starts);
+    free(degree_start);
+    free(level);
+    free(queue);
+    return 1;
+}
+
+// Ширина ленты: наибольшая разность номеров концов ребра
+static int bandwidth(const Edge* edges, int num_edges, const int* old_to_new) {
+    int result = 0;
+    for (int i = 0; i < num_edges; i++) {
+        int u = old_to_new ? old_to_new[edges[i].u] : edges[i].u;
+        int v = old_to_new ? old_to_new[edges[i].v] : edges[i].v;
+        int width = u > v ? u - v : v - u;
+        if (width > result) result = width;
+    }
+    return result;
+}
+
+Graph* reorder_graph(const Graph* graph, VertexOrder order, int** new_to_old) {
+    int n = graph->num_vertices;
+    int num_edges = 0;
+    Edge* edges = graph_edge_list(graph, &num_edges);
+    Graph* own_csr = NULL;
+    const Graph* csr = edges ? graph_csr_view(graph, &own_csr) : NULL;
+    int* permutation = (int*)malloc(n * sizeof(int));
+    int* old_to_new = (int*)malloc(n * sizeof(int));
+    uint64_t* keys = (uint64_t*)malloc(((size_t)num_edges + 1) * sizeof(uint64_t));
+    Graph* result = NULL;
+    if (edges && csr && permutation && old_to_new && keys && bfs_order(csr, order, permutation)) {
+        for (int i = 0; i < n; i++) {
+            old_to_new[permutation[i]] = i;
+        }
+        // Рёбра в новой нумерации упорядочиваются той же поразрядной сортировкой ключей
+        for (int i = 0; i < num_edges; i++) {
+            int u = old_to_new[edges[i].u];
+            int v = old_to_new[edges[i].v];
+            keys[i] = u < v ? edge_key(u, v) : edge_key(v, u);
+        }
+        log_message("\nVertex renumbering (%s): bandwidth %d -> %d\n",
+                    order == VERTEX_ORDER_RCM ? "reverse Cuthill-McKee" : "BFS",
+                    bandwidth(edges, num_edges, NULL), bandwidth(edges, num_edges, old_to_new));
+        if (sort_unique_edge_keys(keys, num_edges) == num_edges) {
+            for (int i = 0; i < num_edges; i++) {
+                edges[i].u = edge_key_u(keys[i]);
+                edges[i].v = edge_key_v(keys[i]);
+            }
+            result = create_graph_from_edges(n, edges, num_edges, graph->kind);
+        }
+    }
+    free(keys);
+    free(old_to_new);
+    free(edges);
+    free_graph(own_csr);
+    if (!result) {
+        fprintf(stderr, "Failed to renumber graph vertices.\n");
+        free(permutation);
+        return NULL;
+    }
+    *new_to_old = permutation;
+    return result;
+}
+
+int restore_vertex_order(int* values, const int* new_to_old, int num_vertices) {
+    int* copy = (int*)malloc(num_vertices * sizeof(int));
+    if (!copy) return 0;
+    memcpy(copy, values, num_vertices * sizeof(int));
+    for (int i = 0; i < num_vertices; i++) {
+        values[new_to_old[i]] = copy[i];
+    }
+    free(copy);
+    return 1;
+}
\ No newline at end of file
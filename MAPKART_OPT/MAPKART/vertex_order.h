@@ -0,0 +1,24 @@
+#ifndef VERTEX_ORDER_H
+#define VERTEX_ORDER_H
+
+#include "graph.h"
+
+// Перенумерация вершин графа перед раскраской. Номера регионов идут в порядке
+// обнаружения при обходе растра, поэтому соседи оказываются далеко друг от друга
+// в массиве цветов и в строках смежности. Обход в ширину кладёт соседей рядом.
+typedef enum {
+    VERTEX_ORDER_NONE = 0, // Исходные номера регионов
+    VERTEX_ORDER_BFS,      // Обход в ширину по компонентам
+    VERTEX_ORDER_RCM       // Обратный Cuthill-McKee: минимизирует ширину ленты
+} VertexOrder;
+
+// Строит граф того же вида с перенумерованными вершинами (вершина 0 остаётся на месте).
+// *new_to_old получает перестановку: новая вершина i - это вершина (*new_to_old)[i]
+// исходного графа. Возвращает NULL при нехватке памяти.
+Graph* reorder_graph(const Graph* graph, VertexOrder order, int** new_to_old);
+
+// Переводит значения, посчитанные для перенумерованного графа (например, цвета),
+// обратно в исходную нумерацию. Возвращает 0 при нехватке памяти.
+int restore_vertex_order(int* values, const int* new_to_old, int num_vertices);
+
+#endif // VERTEX_ORDER_H
\ No newline at end of file